@@ -1,6 +1,7 @@
 // parcial2.c
 // Versión mejorada: convolución, rotación, Sobel, resize (concurrencia pthread)
-// Compilar: gcc -o exe parcial2.c -pthread -lm
+// Compilar: gcc -O2 -o exe parcial2.c -pthread -lm
+//           (añadir -march=native para habilitar las rutas AVX2)
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,6 +10,27 @@
 #include <math.h>
 #include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <time.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -20,12 +42,15 @@
 #define MIN_HILOS 1
 #define MAX_HILOS 32
 #define BUFFER_SIZE 512
+#define ALINEACION_BUFFER 64  // alineación de cada fila (línea de caché)
+#define BLOQUES_POR_HILO 8    // trozos de filas por participante en paraleloFilas
 
 typedef struct {
     int ancho;
     int alto;
     int canales;
-    unsigned char*** pixeles; // [alto][ancho][canales]
+    size_t stride;          // bytes por fila (>= ancho * canales, puede incluir relleno)
+    unsigned char* pixeles; // bloque contiguo liberable con free: la fila y empieza en pixeles + y * stride
 } ImagenInfo;
 
 // ============================================================================
@@ -38,6 +63,32 @@ static inline unsigned char clampuc(int v) {
     return (unsigned char)v;
 }
 
+static inline unsigned char* filaPixeles(const ImagenInfo* info, int y) {
+    return info->pixeles + (size_t)y * info->stride;
+}
+
+// Canales afectados por los ajustes de color: el alfa (si existe) se respeta.
+static inline int canalesColor(int canales) {
+    return (canales == 2 || canales == 4) ? canales - 1 : canales;
+}
+
+const char* nombreCanales(int canales) {
+    switch (canales) {
+        case 1: return "Escala de grises";
+        case 2: return "Grises + alfa";
+        case 3: return "RGB";
+        case 4: return "RGBA";
+        default: return "Desconocido";
+    }
+}
+
+// Reloj monotónico en segundos, para medir tiempos de ejecución.
+double tiempoActual(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
 void limpiarBuffer() {
     int c;
     while ((c = getchar()) != '\n' && c != EOF);
@@ -111,932 +162,5229 @@ float validarFloatRango(const char* prompt, float min, float max, float valorDef
 }
 
 // ============================================================================
-// GESTIÓN DE MEMORIA
+// CONTADORES HARDWARE (perf_event_open)
 // ============================================================================
 
-void freeMatriz(unsigned char*** m, int alto, int ancho) {
-    if (!m) return;
-    for (int y = 0; y < alto; y++) {
-        if (m[y]) {
-            if (m[y][0]) free(m[y][0]);
-            free(m[y]);
+// Con el perfilado activo, cada participante de un trabajo medido lee sus
+// propios contadores (abiertos de forma perezosa, uno por hilo y evento,
+// solo espacio de usuario) al empezar y al terminar sus bloques. Cada evento
+// se abre por separado: si el procesador o el hipervisor no expone alguno,
+// los demás se siguen midiendo. Los fallos de página son un evento software
+// y están disponibles incluso sin PMU (máquinas virtuales).
+
+#define NUM_CONTADORES_HW 5
+
+enum {
+    CONTADOR_CICLOS,
+    CONTADOR_INSTRUCCIONES,
+    CONTADOR_FALLOS_LLC,
+    CONTADOR_FALLOS_DTLB,
+    CONTADOR_FALLOS_PAGINA
+};
+
+static const char* nombresContadoresHW[NUM_CONTADORES_HW] = {
+    "ciclos", "instrucciones", "llc_fallos", "dtlb_fallos", "fallos_pagina"
+};
+
+static atomic_int perfilHardwareActivo = 0;
+static atomic_uint avisosPerf = 0;          // bit k: contador k ya avisado; bit 31: permisos
+
+typedef struct {
+    int abierto;
+    int fd[NUM_CONTADORES_HW];              // -1 si el evento no está disponible
+} ContadoresHilo;
+
+static _Thread_local ContadoresHilo contadoresHilo;
+
+typedef struct {
+    uint64_t valor[NUM_CONTADORES_HW];
+    unsigned validos;                       // bit k = valor[k] leído
+} LecturaContadores;
+
+void activarPerfilHardware(int activo) {
+    atomic_store(&perfilHardwareActivo, activo ? 1 : 0);
+}
+
+int perfilHardwareActivado(void) {
+    return atomic_load(&perfilHardwareActivo);
+}
+
+#if defined(__linux__)
+static void avisarContadorNoDisponible(int k, int error) {
+    if (error == EACCES || error == EPERM) {
+        if (atomic_fetch_or(&avisosPerf, 1u << 31) & (1u << 31)) return;
+        int paranoid = -1;
+        FILE* f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+        if (f) {
+            if (fscanf(f, "%d", &paranoid) != 1) paranoid = -1;
+            fclose(f);
         }
+        fprintf(stderr, "⚠ perf_event_open: permiso denegado (perf_event_paranoid = %d). "
+                        "Con un valor <= 2 o CAP_PERFMON se pueden medir los contadores; "
+                        "se continúa sin ellos.\n", paranoid);
+        return;
     }
-    free(m);
+    if (atomic_fetch_or(&avisosPerf, 1u << k) & (1u << k)) return;
+    fprintf(stderr, "⚠ Contador %s no disponible en este sistema (%s)\n", nombresContadoresHW[k], strerror(error));
 }
 
-unsigned char*** crearMatrizPixeles(int alto, int ancho, int canales) {
-    if (alto <= 0 || ancho <= 0 || canales <= 0) {
-        fprintf(stderr, "❌ Error: Dimensiones inválidas (%dx%d, %d canales)\n", ancho, alto, canales);
-        return NULL;
-    }
-    
-    unsigned char*** m = malloc((size_t)alto * sizeof(unsigned char**));
-    if (!m) {
-        fprintf(stderr, "❌ Error: No se pudo asignar memoria para %d filas\n", alto);
-        return NULL;
-    }
-    
-    for (int y = 0; y < alto; y++) m[y] = NULL;
+static int abrirContador(uint32_t tipo, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = tipo;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
 
-    for (int y = 0; y < alto; y++) {
-        m[y] = malloc((size_t)ancho * sizeof(unsigned char*));
-        if (!m[y]) {
-            fprintf(stderr, "❌ Error: Memoria insuficiente en fila %d\n", y);
-            for (int yy = 0; yy < y; yy++) {
-                if (m[yy]) {
-                    if (m[yy][0]) free(m[yy][0]);
-                    free(m[yy]);
-                }
-            }
-            free(m);
-            return NULL;
-        }
-        
-        size_t rowSize = (size_t)ancho * (size_t)canales * sizeof(unsigned char);
-        unsigned char* rowBlock = malloc(rowSize);
-        if (!rowBlock) {
-            fprintf(stderr, "❌ Error: Memoria insuficiente para datos de fila %d\n", y);
-            free(m[y]);
-            for (int yy = 0; yy < y; yy++) {
-                if (m[yy]) {
-                    if (m[yy][0]) free(m[yy][0]);
-                    free(m[yy]);
-                }
-            }
-            free(m);
-            return NULL;
-        }
-        
-        for (int x = 0; x < ancho; x++) {
-            m[y][x] = rowBlock + (size_t)x * (size_t)canales;
-        }
-        
-        memset(rowBlock, 0, rowSize);
+static void abrirContadoresHilo(ContadoresHilo* c) {
+    const uint64_t lecturaFallo = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const struct { uint32_t tipo; uint64_t config; } eventos[NUM_CONTADORES_HW] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | lecturaFallo},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | lecturaFallo},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    };
+    
+    c->abierto = 1;
+    for (int k = 0; k < NUM_CONTADORES_HW; k++) {
+        c->fd[k] = abrirContador(eventos[k].tipo, eventos[k].config);
+        if (c->fd[k] < 0) avisarContadorNoDisponible(k, errno);
     }
-    return m;
 }
 
-void liberarImagen(ImagenInfo* info) {
-    if (!info) return;
-    
-    if (info->pixeles) {
-        for (int y = 0; y < info->alto; y++) {
-            if (info->pixeles[y]) {
-                if (info->pixeles[y][0]) free(info->pixeles[y][0]);
-                free(info->pixeles[y]);
-            }
-        }
-        free(info->pixeles);
-        info->pixeles = NULL;
+// Valores acumulados de los contadores del hilo actual, escalados si el
+// kernel los multiplexó (tiempo activo < tiempo habilitado).
+static void leerContadoresHilo(LecturaContadores* l) {
+    ContadoresHilo* c = &contadoresHilo;
+    if (!c->abierto) abrirContadoresHilo(c);
+    
+    l->validos = 0;
+    for (int k = 0; k < NUM_CONTADORES_HW; k++) {
+        uint64_t datos[3];              // valor, tiempo habilitado, tiempo activo
+        l->valor[k] = 0;
+        if (c->fd[k] < 0 || read(c->fd[k], datos, sizeof(datos)) != (ssize_t)sizeof(datos)) continue;
+        l->valor[k] = (datos[2] > 0 && datos[2] < datos[1])
+                    ? (uint64_t)((double)datos[0] * datos[1] / datos[2]) : datos[0];
+        l->validos |= 1u << k;
     }
-    info->ancho = 0;
-    info->alto = 0;
-    info->canales = 0;
 }
+#else
+static void leerContadoresHilo(LecturaContadores* l) {
+    if (!(atomic_fetch_or(&avisosPerf, 1u << 31) & (1u << 31))) {
+        fprintf(stderr, "⚠ Contadores hardware solo disponibles en Linux (perf_event_open)\n");
+    }
+    memset(l, 0, sizeof(*l));
+}
+#endif
 
 // ============================================================================
-// CARGA Y GUARDADO DE IMÁGENES
+// TRAZA DE EJECUCIÓN (CHROME TRACE / PERFETTO)
 // ============================================================================
 
-int cargarImagen(const char* ruta, ImagenInfo* info) {
-    if (!ruta || !info) {
-        fprintf(stderr, "❌ Error: Parámetros inválidos\n");
-        return 0;
-    }
-    
-    printf("📂 Cargando imagen: %s...\n", ruta);
-    
-    int orig_channels = 0;
-    int w = 0, h = 0;
-    unsigned char* datos = stbi_load(ruta, &w, &h, &orig_channels, 0);
-    
-    if (!datos) {
-        fprintf(stderr, "❌ Error: No se pudo cargar la imagen '%s'\n", ruta);
-        fprintf(stderr, "   Verifica que el archivo existe y es un formato válido (PNG, JPG, BMP, etc.)\n");
-        return 0;
+// Cada hilo anota sus eventos en un buffer propio (sin bloqueos; el mutex
+// solo protege el alta del buffer en la lista global). Los eventos son
+// intervalos completos ("ph": "X") con inicio y duración, que Perfetto o
+// chrome://tracing muestran en una pista por hilo: operaciones en el hilo
+// que las lanza, bloques de filas en cada participante del pool, reservas
+// de imagen y decodificación/codificación en los hilos de E/S.
+
+typedef struct {
+    const char* categoria;          // literal: "operacion", "filas", "memoria", "es"
+    char nombre[48];
+    char detalle[64];
+    int filaInicio, filaFin;        // rango de filas (-1 si no aplica)
+    double inicio, duracion;        // segundos desde el inicio de la traza
+} EventoTraza;
+
+typedef struct BufferTraza {
+    int tid;
+    char nombreHilo[32];
+    EventoTraza* eventos;
+    int num, capacidad;
+    struct BufferTraza* sig;
+} BufferTraza;
+
+static struct {
+    pthread_mutex_t mutex;
+    BufferTraza* buffers;
+    int siguienteTid;
+    double origen;
+    atomic_int activa;
+} traza = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static _Thread_local BufferTraza* trazaHilo = NULL;
+static _Thread_local char nombreHiloTraza[32] = "";
+
+static inline int trazando(void) {
+    return atomic_load_explicit(&traza.activa, memory_order_relaxed);
+}
+
+// Nombre de la pista del hilo actual; debe fijarse antes de su primer evento.
+void nombrarHiloTraza(const char* nombre) {
+    snprintf(nombreHiloTraza, sizeof(nombreHiloTraza), "%s", nombre);
+}
+
+// Descarta lo anotado hasta ahora y empieza a registrar eventos.
+void iniciarTraza(void) {
+    pthread_mutex_lock(&traza.mutex);
+    for (BufferTraza* b = traza.buffers; b; b = b->sig) b->num = 0;
+    traza.origen = tiempoActual();
+    atomic_store(&traza.activa, 1);
+    pthread_mutex_unlock(&traza.mutex);
+}
+
+void detenerTraza(void) {
+    atomic_store(&traza.activa, 0);
+}
+
+static inline double inicioTraza(void) {
+    return trazando() ? tiempoActual() : 0.0;
+}
+
+static BufferTraza* bufferTrazaHilo(void) {
+    if (trazaHilo) return trazaHilo;
+    
+    BufferTraza* b = (BufferTraza*)calloc(1, sizeof(BufferTraza));
+    if (!b) return NULL;
+    pthread_mutex_lock(&traza.mutex);
+    b->tid = ++traza.siguienteTid;
+    if (nombreHiloTraza[0]) snprintf(b->nombreHilo, sizeof(b->nombreHilo), "%s", nombreHiloTraza);
+    else snprintf(b->nombreHilo, sizeof(b->nombreHilo), "hilo %d", b->tid);
+    b->sig = traza.buffers;
+    traza.buffers = b;
+    pthread_mutex_unlock(&traza.mutex);
+    
+    trazaHilo = b;
+    return b;
+}
+
+// Anota el intervalo [inicio, ahora). inicio viene de inicioTraza(): si la
+// traza no estaba activa al empezar (0.0) el evento se ignora.
+void registrarTraza(const char* categoria, const char* nombre, double inicio,
+                    int filaInicio, int filaFin, const char* detalle) {
+    if (inicio <= 0.0 || !trazando()) return;
+    double fin = tiempoActual();
+    
+    BufferTraza* b = bufferTrazaHilo();
+    if (!b) return;
+    if (b->num == b->capacidad) {
+        int capacidad = b->capacidad ? b->capacidad * 2 : 1024;
+        EventoTraza* nuevos = (EventoTraza*)realloc(b->eventos, (size_t)capacidad * sizeof(EventoTraza));
+        if (!nuevos) return;
+        b->eventos = nuevos;
+        b->capacidad = capacidad;
     }
     
-    int desired = (orig_channels == 1 || orig_channels == 3) ? orig_channels : 3;
-    if (orig_channels != desired) {
-        stbi_image_free(datos);
-        datos = stbi_load(ruta, &w, &h, &orig_channels, desired);
-        if (!datos) {
-            fprintf(stderr, "❌ Error: No se pudo convertir imagen a %d canales\n", desired);
-            return 0;
-        }
-        orig_channels = desired;
+    EventoTraza* e = &b->eventos[b->num++];
+    e->categoria = categoria;
+    snprintf(e->nombre, sizeof(e->nombre), "%s", nombre);
+    snprintf(e->detalle, sizeof(e->detalle), "%s", detalle ? detalle : "");
+    e->filaInicio = filaInicio;
+    e->filaFin = filaFin;
+    e->inicio = inicio - traza.origen;
+    e->duracion = fin - inicio;
+}
+
+static void escribirCadenaJSON(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
     }
-    
-    info->ancho = w;
-    info->alto = h;
-    info->canales = orig_channels;
-    
-    printf("   Dimensiones: %dx%d píxeles\n", w, h);
-    printf("   Canales: %d (%s)\n", orig_channels, orig_channels == 1 ? "Escala de grises" : "RGB");
-    
-    info->pixeles = crearMatrizPixeles(h, w, info->canales);
-    if (!info->pixeles) {
-        fprintf(stderr, "❌ Error: No hay memoria suficiente para cargar la imagen\n");
-        stbi_image_free(datos);
+    fputc('"', f);
+}
+
+// Escribe la traza en formato Chrome Trace Event (JSON), que abren
+// ui.perfetto.dev y chrome://tracing. Debe llamarse sin trabajos en curso.
+int exportarTraza(const char* ruta) {
+    FILE* f = fopen(ruta, "w");
+    if (!f) {
+        fprintf(stderr, "❌ No se pudo escribir %s: %s\n", ruta, strerror(errno));
         return 0;
     }
     
-    for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            for (int c = 0; c < info->canales; c++) {
-                info->pixeles[y][x][c] = datos[(y * w + x) * info->canales + c];
+    pthread_mutex_lock(&traza.mutex);
+    long total = 0;
+    int primero = 1;
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (BufferTraza* b = traza.buffers; b; b = b->sig) {
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",
+                primero ? "" : ",\n", b->tid);
+        escribirCadenaJSON(f, b->nombreHilo);
+        fprintf(f, "}}");
+        primero = 0;
+        
+        for (int i = 0; i < b->num; i++) {
+            const EventoTraza* e = &b->eventos[i];
+            fprintf(f, ",\n{\"name\": ");
+            escribirCadenaJSON(f, e->nombre);
+            fprintf(f, ", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {",
+                    e->categoria, b->tid, e->inicio * 1e6, e->duracion * 1e6);
+            if (e->filaInicio >= 0) {
+                fprintf(f, "\"filas\": [%d, %d]%s", e->filaInicio, e->filaFin, e->detalle[0] ? ", " : "");
+            }
+            if (e->detalle[0]) {
+                fprintf(f, "\"detalle\": ");
+                escribirCadenaJSON(f, e->detalle);
             }
+            fprintf(f, "}}");
         }
+        total += b->num;
     }
+    fprintf(f, "\n]}\n");
+    pthread_mutex_unlock(&traza.mutex);
     
-    stbi_image_free(datos);
-    printf("✓ Imagen cargada exitosamente\n");
+    if (fclose(f) != 0) {
+        fprintf(stderr, "❌ Error al escribir %s\n", ruta);
+        return 0;
+    }
+    printf("📝 Traza con %ld eventos guardada en %s (ábrala en ui.perfetto.dev)\n", total, ruta);
     return 1;
 }
 
-int guardarPNG(const ImagenInfo* info, const char* rutaSalida) {
-    if (!info || !rutaSalida) {
-        fprintf(stderr, "❌ Error: Parámetros inválidos\n");
-        return 0;
-    }
-    
-    if (!info->pixeles) {
-        fprintf(stderr, "❌ Error: No hay imagen cargada para guardar\n");
-        return 0;
-    }
-    
-    if (info->ancho <= 0 || info->alto <= 0 || info->canales <= 0) {
-        fprintf(stderr, "❌ Error: Dimensiones de imagen inválidas (%dx%d, %d canales)\n", 
-                info->ancho, info->alto, info->canales);
-        return 0;
-    }
-    
-    printf("💾 Guardando imagen: %s\n", rutaSalida);
-    printf("   Dimensiones: %dx%d, %d canales\n", info->ancho, info->alto, info->canales);
+// ============================================================================
+// MÉTRICAS POR OPERACIÓN
+// ============================================================================
+
+#define MAX_HISTORIAL_METRICAS 256
+
+// Métricas de una operación (un filtro, una carga, un guardado...). El hilo
+// que la ejecuta las activa con iniciarMetricas; paraleloFilas captura el
+// puntero al enviar cada trabajo y cada participante acumula su tiempo
+// ocupado en la posición de su hiloId, que es exclusiva dentro de un
+// trabajo, así que no hace falta sincronización adicional.
+typedef struct {
+    char nombre[64];
+    int hilosPedidos;
+    int hilosUsados;            // hiloIds que procesaron algún bloque
+    int numTrabajos;            // llamadas a paraleloFilas
+    double inicio;              // tiempoActual() al empezar
+    double inicioTraza;         // igual que inicio si la traza estaba activa, si no 0
+    double tiempoPared;
+    double tiempoReserva;       // crearMatrizPixeles (incluye el memset) y buffers intermedios
+    size_t bytesReservados;
+    int numReservas;
+    double ocupado[MAX_HILOS];  // segundos dentro de la tarea, por hiloId
+    int bloques[MAX_HILOS];
+    double megapixeles;         // el mayor entre la imagen de entrada y la de salida
+    int perfilHardware;         // contadores activos al iniciar la operación
+    unsigned contadoresValidos[MAX_HILOS];
+    uint64_t contadores[MAX_HILOS][NUM_CONTADORES_HW];
+} MetricasOperacion;
+
+static _Thread_local MetricasOperacion* metricasHilo = NULL;
+
+// Registran operaciones el hilo principal y, en el modo por lotes, los
+// decodificadores y codificadores; el mutex protege las inserciones.
+static struct {
+    MetricasOperacion entradas[MAX_HISTORIAL_METRICAS];
+    int num;                    // total registradas; las más antiguas se sobrescriben
+    pthread_mutex_t mutex;
+} historialMetricas = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static double megapixelesImagen(const ImagenInfo* info) {
+    return (info && info->pixeles) ? (double)info->ancho * info->alto / 1e6 : 0.0;
+}
+
+// entrada puede ser NULL o no tener píxeles (p. ej. antes de cargar)
+void iniciarMetricas(MetricasOperacion* m, const char* nombre, int hilosPedidos, const ImagenInfo* entrada) {
+    memset(m, 0, sizeof(*m));
+    snprintf(m->nombre, sizeof(m->nombre), "%s", nombre);
+    m->hilosPedidos = hilosPedidos;
+    m->megapixeles = megapixelesImagen(entrada);
+    m->perfilHardware = perfilHardwareActivado();
+    m->inicio = tiempoActual();
+    m->inicioTraza = trazando() ? m->inicio : 0.0;
+    metricasHilo = m;
+}
+
+void finalizarMetricas(MetricasOperacion* m, const ImagenInfo* salida) {
+    m->tiempoPared = tiempoActual() - m->inicio;
+    if (metricasHilo == m) metricasHilo = NULL;
     
-    int stride = info->ancho * info->canales;
-    size_t total = (size_t)info->alto * (size_t)stride;
+    double mpSalida = megapixelesImagen(salida);
+    if (mpSalida > m->megapixeles) m->megapixeles = mpSalida;
     
-    unsigned char* datos1D = malloc(total);
-    if (!datos1D) {
-        fprintf(stderr, "❌ Error: Memoria insuficiente para guardar imagen\n");
-        return 0;
+    m->hilosUsados = 0;
+    for (int i = 0; i < MAX_HILOS; i++) {
+        if (m->bloques[i] > 0) m->hilosUsados++;
     }
     
-    memset(datos1D, 0, total);
+    char detalle[64];
+    snprintf(detalle, sizeof(detalle), "%d/%d hilos, %.2f MP", m->hilosUsados, m->hilosPedidos, m->megapixeles);
+    registrarTraza("operacion", m->nombre, m->inicioTraza, -1, -1, detalle);
     
-    for (int y = 0; y < info->alto; y++) {
-        for (int x = 0; x < info->ancho; x++) {
-            for (int c = 0; c < info->canales; c++) {
-                size_t idx = (size_t)y * stride + (size_t)x * info->canales + c;
-                if (idx < total) {
-                    datos1D[idx] = info->pixeles[y][x][c];
-                }
-            }
-        }
+    pthread_mutex_lock(&historialMetricas.mutex);
+    historialMetricas.entradas[historialMetricas.num % MAX_HISTORIAL_METRICAS] = *m;
+    historialMetricas.num++;
+    pthread_mutex_unlock(&historialMetricas.mutex);
+}
+
+// Puntero a la entrada más reciente; solo es estable mientras nadie más
+// registra operaciones (menú y pipeline, no durante un lote).
+const MetricasOperacion* ultimaMetrica(void) {
+    if (historialMetricas.num == 0) return NULL;
+    return &historialMetricas.entradas[(historialMetricas.num - 1) % MAX_HISTORIAL_METRICAS];
+}
+
+static inline void acumularContadores(MetricasOperacion* m, int hiloId, const LecturaContadores* antes) {
+    LecturaContadores despues;
+    leerContadoresHilo(&despues);
+    unsigned validos = antes->validos & despues.validos;
+    for (int k = 0; k < NUM_CONTADORES_HW; k++) {
+        if (validos & (1u << k)) m->contadores[hiloId][k] += despues.valor[k] - antes->valor[k];
     }
-    
-    int res = stbi_write_png(rutaSalida, info->ancho, info->alto, info->canales, datos1D, stride);
-    free(datos1D);
-    
-    if (res) {
-        printf("✓ Imagen guardada exitosamente\n");
-        return 1;
-    } else {
-        fprintf(stderr, "❌ Error: No se pudo guardar el archivo PNG\n");
-        return 0;
+    m->contadoresValidos[hiloId] |= validos;
+}
+
+// Suma de un contador en todos los hilos; 0 si ningún hilo lo pudo medir.
+static int totalContador(const MetricasOperacion* m, int k, uint64_t* total) {
+    int medido = 0;
+    *total = 0;
+    for (int i = 0; i < MAX_HILOS; i++) {
+        if (!(m->contadoresValidos[i] & (1u << k))) continue;
+        *total += m->contadores[i][k];
+        medido = 1;
     }
+    return medido;
 }
 
-void mostrarMatriz(const ImagenInfo* info) {
-    if (!info || !info->pixeles) {
-        printf("❌ No hay imagen cargada\n");
-        return;
+// Resumen de los contadores: IPC y fallos por megapíxel ("n/d" si no se midió).
+void describirContadores(const MetricasOperacion* m, char* texto, size_t tam) {
+    uint64_t ciclos, instrucciones, v;
+    int largo = 0;
+    if (totalContador(m, CONTADOR_CICLOS, &ciclos) && totalContador(m, CONTADOR_INSTRUCCIONES, &instrucciones) &&
+        ciclos > 0) {
+        largo = snprintf(texto, tam, "IPC %.2f", (double)instrucciones / ciclos);
+    } else {
+        largo = snprintf(texto, tam, "IPC n/d");
     }
     
-    printf("\n📊 Información de la imagen:\n");
-    printf("   Dimensiones: %dx%d píxeles\n", info->ancho, info->alto);
-    printf("   Canales: %d (%s)\n", info->canales, info->canales == 1 ? "Grises" : "RGB");
-    printf("   Memoria: ~%.2f MB\n", 
-           (info->alto * info->ancho * info->canales) / (1024.0 * 1024.0));
-    
-    printf("\n📋 Primeras filas de la matriz (máximo 8 filas x 12 columnas):\n");
-    int maxFilas = (info->alto < 8) ? info->alto : 8;
-    int maxCols = (info->ancho < 12) ? info->ancho : 12;
-    
-    for (int y = 0; y < maxFilas; y++) {
-        printf("   ");
-        for (int x = 0; x < maxCols; x++) {
-            if (info->canales == 1) {
-                printf("%3u ", info->pixeles[y][x][0]);
-            } else {
-                printf("(%3u,%3u,%3u) ", 
-                       info->pixeles[y][x][0], 
-                       info->pixeles[y][x][1], 
-                       info->pixeles[y][x][2]);
-            }
+    const int claves[3] = {CONTADOR_FALLOS_LLC, CONTADOR_FALLOS_DTLB, CONTADOR_FALLOS_PAGINA};
+    const char* etiquetas[3] = {"LLC", "dTLB", "pág."};
+    for (int j = 0; j < 3 && largo > 0 && (size_t)largo < tam; j++) {
+        if (totalContador(m, claves[j], &v) && m->megapixeles > 0.0) {
+            largo += snprintf(texto + largo, tam - (size_t)largo, " | %s %.0f/MP", etiquetas[j], v / m->megapixeles);
+        } else {
+            largo += snprintf(texto + largo, tam - (size_t)largo, " | %s n/d", etiquetas[j]);
         }
-        printf("\n");
-    }
-    
-    if (info->alto > maxFilas) {
-        printf("   ... (%d filas más)\n", info->alto - maxFilas);
     }
 }
 
-// ============================================================================
-// BRILLO CONCURRENTE
-// ============================================================================
+static inline double inicioReserva(void) {
+    return (metricasHilo || trazando()) ? tiempoActual() : 0.0;
+}
 
-typedef struct {
-    unsigned char*** pixeles;
-    int inicio, fin, ancho, canales;
-    int delta;
-    int hiloId;
-} BrilloArgs;
+static inline void registrarReserva(double inicio, size_t bytes, const char* nombre) {
+    if (inicio > 0.0 && trazando()) {
+        char detalle[64];
+        snprintf(detalle, sizeof(detalle), "%.2f MB", bytes / (1024.0 * 1024.0));
+        registrarTraza("memoria", nombre, inicio, -1, -1, detalle);
+    }
+    MetricasOperacion* m = metricasHilo;
+    if (!m) return;
+    m->tiempoReserva += tiempoActual() - inicio;
+    m->bytesReservados += bytes;
+    m->numReservas++;
+}
 
-void* ajustarBrilloHilo(void* arg) {
-    BrilloArgs* a = (BrilloArgs*)arg;
-    
-    for (int y = a->inicio; y < a->fin; y++) {
-        for (int x = 0; x < a->ancho; x++) {
-            for (int c = 0; c < a->canales; c++) {
-                int v = (int)a->pixeles[y][x][c] + a->delta;
-                a->pixeles[y][x][c] = clampuc(v);
-            }
-        }
+// Hilo más ocupado frente a la media de los que trabajaron (1.0 = reparto perfecto)
+double desbalanceMetricas(const MetricasOperacion* m) {
+    double suma = 0.0, maximo = 0.0;
+    int n = 0;
+    for (int i = 0; i < MAX_HILOS; i++) {
+        if (m->bloques[i] == 0) continue;
+        suma += m->ocupado[i];
+        if (m->ocupado[i] > maximo) maximo = m->ocupado[i];
+        n++;
     }
-    
-    return NULL;
+    return (n > 0 && suma > 0.0) ? maximo * n / suma : 1.0;
 }
 
-void ajustarBrilloConcurrente(ImagenInfo* info, int delta, int numHilos) {
-    if (!info || !info->pixeles) {
-        printf("❌ No hay imagen cargada\n");
-        return;
+// Fracción del tiempo de pared en que los hilos usados estuvieron dentro
+// de una tarea; lo que falta son esperas, reservas y tramos secuenciales.
+double utilizacionMetricas(const MetricasOperacion* m) {
+    double suma = 0.0;
+    for (int i = 0; i < MAX_HILOS; i++) suma += m->ocupado[i];
+    if (m->hilosUsados == 0 || m->tiempoPared <= 0.0) return 0.0;
+    return suma / (m->tiempoPared * m->hilosUsados);
+}
+
+// Vuelca el historial (en orden de finalización) como JSON. Los instantes
+// de inicio se miden desde la operación que empezó antes.
+int exportarMetricasJSON(const char* ruta) {
+    FILE* f = fopen(ruta, "w");
+    if (!f) {
+        fprintf(stderr, "❌ No se pudo escribir %s: %s\n", ruta, strerror(errno));
+        return 0;
     }
     
-    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
-    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
-    if (numHilos > info->alto) numHilos = info->alto;
-    
-    printf("🔧 Ajustando brillo %s%d con %d hilos...\n", 
-           delta >= 0 ? "+" : "", delta, numHilos);
-    
-    pthread_t* hilos = malloc(sizeof(pthread_t) * (size_t)numHilos);
-    BrilloArgs* args = malloc(sizeof(BrilloArgs) * (size_t)numHilos);
-    
-    if (!hilos || !args) {
-        fprintf(stderr, "❌ Error: Memoria insuficiente para hilos\n");
-        free(hilos);
-        free(args);
-        return;
+    pthread_mutex_lock(&historialMetricas.mutex);
+    int num = historialMetricas.num < MAX_HISTORIAL_METRICAS ? historialMetricas.num : MAX_HISTORIAL_METRICAS;
+    int primera = historialMetricas.num - num;
+    double origen = num > 0 ? historialMetricas.entradas[primera % MAX_HISTORIAL_METRICAS].inicio : 0.0;
+    for (int k = 1; k < num; k++) {
+        double inicio = historialMetricas.entradas[(primera + k) % MAX_HISTORIAL_METRICAS].inicio;
+        if (inicio < origen) origen = inicio;
     }
     
-    int filasPor = (info->alto + numHilos - 1) / numHilos;
-    int hilosCreados = 0;
-    
-    for (int i = 0; i < numHilos; i++) {
-        args[i].pixeles = info->pixeles;
-        args[i].inicio = i * filasPor;
-        args[i].fin = ((i + 1) * filasPor < info->alto) ? (i + 1) * filasPor : info->alto;
-        args[i].ancho = info->ancho;
-        args[i].canales = info->canales;
-        args[i].delta = delta;
-        args[i].hiloId = i;
+    fprintf(f, "{\n  \"operaciones\": [\n");
+    for (int k = 0; k < num; k++) {
+        const MetricasOperacion* m = &historialMetricas.entradas[(primera + k) % MAX_HISTORIAL_METRICAS];
+        int ultimoHilo = 0;
+        for (int i = 0; i < MAX_HILOS; i++) {
+            if (m->bloques[i] > 0) ultimoHilo = i + 1;
+        }
         
-        if (args[i].inicio < args[i].fin) {
-            if (pthread_create(&hilos[i], NULL, ajustarBrilloHilo, &args[i]) != 0) {
-                fprintf(stderr, "⚠ Advertencia: No se pudo crear hilo %d\n", i);
-                args[i].inicio = args[i].fin;
-            } else {
-                hilosCreados++;
+        fprintf(f, "    {\"nombre\": ");
+        escribirCadenaJSON(f, m->nombre);
+        fprintf(f, ", \"inicio_ms\": %.3f, \"pared_ms\": %.3f, \"reserva_ms\": %.3f, "
+                   "\"bytes_reservados\": %zu, \"reservas\": %d, \"trabajos\": %d, "
+                   "\"hilos_pedidos\": %d, \"hilos_usados\": %d, \"desbalance\": %.3f, \"utilizacion\": %.3f,\n",
+                (m->inicio - origen) * 1e3, m->tiempoPared * 1e3, m->tiempoReserva * 1e3,
+                m->bytesReservados, m->numReservas, m->numTrabajos, m->hilosPedidos, m->hilosUsados,
+                desbalanceMetricas(m), utilizacionMetricas(m));
+        fprintf(f, "     \"megapixeles\": %.3f, \"ocupado_ms\": [", m->megapixeles);
+        for (int i = 0; i < ultimoHilo; i++) fprintf(f, "%s%.3f", i ? ", " : "", m->ocupado[i] * 1e3);
+        fprintf(f, "], \"bloques\": [");
+        for (int i = 0; i < ultimoHilo; i++) fprintf(f, "%s%d", i ? ", " : "", m->bloques[i]);
+        fprintf(f, "]");
+        
+        if (m->perfilHardware) {
+            // Totales y por megapíxel; null si el contador no estaba disponible
+            fprintf(f, ",\n     \"contadores\": {");
+            for (int c = 0; c < NUM_CONTADORES_HW; c++) {
+                uint64_t total;
+                int medido = totalContador(m, c, &total);
+                fprintf(f, "%s\"%s\": ", c ? ", " : "", nombresContadoresHW[c]);
+                if (medido) fprintf(f, "%llu", (unsigned long long)total);
+                else fprintf(f, "null");
+                if (c >= CONTADOR_FALLOS_LLC) {
+                    fprintf(f, ", \"%s_por_mp\": ", nombresContadoresHW[c]);
+                    if (medido && m->megapixeles > 0.0) fprintf(f, "%.1f", total / m->megapixeles);
+                    else fprintf(f, "null");
+                }
             }
+            fprintf(f, "},\n     \"ipc_hilo\": [");
+            for (int i = 0; i < ultimoHilo; i++) {
+                uint64_t ciclos = m->contadores[i][CONTADOR_CICLOS];
+                unsigned ambos = (1u << CONTADOR_CICLOS) | (1u << CONTADOR_INSTRUCCIONES);
+                if ((m->contadoresValidos[i] & ambos) == ambos && ciclos > 0) {
+                    fprintf(f, "%s%.3f", i ? ", " : "", (double)m->contadores[i][CONTADOR_INSTRUCCIONES] / ciclos);
+                } else {
+                    fprintf(f, "%snull", i ? ", " : "");
+                }
+            }
+            fprintf(f, "]");
         }
+        fprintf(f, "}%s\n", k + 1 < num ? "," : "");
     }
+    fprintf(f, "  ]\n}\n");
+    pthread_mutex_unlock(&historialMetricas.mutex);
     
-    for (int i = 0; i < numHilos; i++) {
-        if (args[i].inicio < args[i].fin) {
-            pthread_join(hilos[i], NULL);
-        }
+    if (fclose(f) != 0) {
+        fprintf(stderr, "❌ Error al escribir %s\n", ruta);
+        return 0;
     }
-    
-    free(hilos);
-    free(args);
-    printf("✓ Brillo ajustado correctamente (%d hilos utilizados)\n", hilosCreados);
+    printf("📝 Métricas de %d operación(es) guardadas en %s\n", num, ruta);
+    return 1;
 }
 
 // ============================================================================
-// INTERPOLACIÓN BILINEAL
+// GESTIÓN DE MEMORIA
 // ============================================================================
 
-void sampleBilinear(unsigned char*** src, int srcW, int srcH, int channels, 
-                     float fx, float fy, unsigned char* out) {
-    if (channels <= 0) return;
-    
-    int x0 = (int)floorf(fx);
-    int y0 = (int)floorf(fy);
-    int x1 = x0 + 1;
-    int y1 = y0 + 1;
+// Reserva un único bloque alineado para toda la imagen. Cada fila ocupa
+// *stride bytes (ancho * canales redondeado a ALINEACION_BUFFER) para que
+// todas las filas empiecen alineadas.
+unsigned char* crearMatrizPixeles(int alto, int ancho, int canales, size_t* stride) {
+    if (alto <= 0 || ancho <= 0 || canales <= 0) {
+        fprintf(stderr, "❌ Error: Dimensiones inválidas (%dx%d, %d canales)\n", ancho, alto, canales);
+        return NULL;
+    }
     
-    float dx = fx - x0;
-    float dy = fy - y0;
+    size_t bytesFila = (size_t)ancho * (size_t)canales;
+    size_t paso = (bytesFila + ALINEACION_BUFFER - 1) & ~(size_t)(ALINEACION_BUFFER - 1);
     
-    if (x0 < 0) x0 = 0;
-    if (y0 < 0) y0 = 0;
-    if (x1 >= srcW) x1 = srcW - 1;
-    if (y1 >= srcH) y1 = srcH - 1;
+    if (paso < bytesFila || (size_t)alto > SIZE_MAX / paso) {
+        fprintf(stderr, "❌ Error: Imagen demasiado grande (%dx%d, %d canales)\n", ancho, alto, canales);
+        return NULL;
+    }
     
-    for (int c = 0; c < channels; c++) {
-        float v00 = src[y0][x0][c];
-        float v10 = src[y0][x1][c];
-        float v01 = src[y1][x0][c];
-        float v11 = src[y1][x1][c];
-        
-        float v0 = v00 * (1 - dx) + v10 * dx;
-        float v1 = v01 * (1 - dx) + v11 * dx;
-        float v = v0 * (1 - dy) + v1 * dy;
-        
-        out[c] = clampuc((int)roundf(v));
+    size_t total = paso * (size_t)alto;
+    void* bloque = NULL;
+    double t0 = inicioReserva();
+    if (posix_memalign(&bloque, ALINEACION_BUFFER, total) != 0) {
+        fprintf(stderr, "❌ Error: No se pudo asignar memoria para %dx%d píxeles (%.2f MB)\n",
+                ancho, alto, total / (1024.0 * 1024.0));
+        return NULL;
     }
+    
+    memset(bloque, 0, total);
+    registrarReserva(t0, total, "crearMatrizPixeles");
+    if (stride) *stride = paso;
+    return (unsigned char*)bloque;
+}
+
+int crearImagen(ImagenInfo* info, int ancho, int alto, int canales) {
+    info->ancho = ancho;
+    info->alto = alto;
+    info->canales = canales;
+    info->stride = 0;
+    info->pixeles = crearMatrizPixeles(alto, ancho, canales, &info->stride);
+    return info->pixeles != NULL;
+}
+
+void liberarImagen(ImagenInfo* info) {
+    if (!info) return;
+    
+    free(info->pixeles);
+    info->pixeles = NULL;
+    info->ancho = 0;
+    info->alto = 0;
+    info->canales = 0;
+    info->stride = 0;
 }
 
 // ============================================================================
-// CONVOLUCIÓN GAUSSIANA
+// POOL DE HILOS PERSISTENTE
 // ============================================================================
 
-typedef struct {
-    unsigned char*** src;
-    unsigned char*** dst;
-    int inicio, fin, ancho, alto, canales, tamKernel;
-    float* kernel;
-    int hiloId;
-} ConvArgs;
+// Tarea paralela sobre un rango de filas [inicio, fin). hiloId identifica al
+// participante (0 = hilo que envió el trabajo) dentro de esa ejecución.
+typedef void (*TareaFilas)(void* ctx, int inicio, int fin, int hiloId);
 
-void* aplicarConvolucionHilo(void* arg) {
-    ConvArgs* a = (ConvArgs*)arg;
-    int k2 = a->tamKernel / 2;
-    
-    for (int y = a->inicio; y < a->fin; y++) {
-        for (int x = 0; x < a->ancho; x++) {
-            for (int c = 0; c < a->canales; c++) {
-                float acc = 0.0f;
-                
-                for (int ky = -k2; ky <= k2; ky++) {
-                    for (int kx = -k2; kx <= k2; kx++) {
-                        int yy = y + ky;
-                        int xx = x + kx;
-                        
-                        if (yy < 0) yy = 0;
-                        if (yy >= a->alto) yy = a->alto - 1;
-                        if (xx < 0) xx = 0;
-                        if (xx >= a->ancho) xx = a->ancho - 1;
+typedef struct TrabajoFilas {
+    TareaFilas tarea;
+    void* ctx;
+    int total;
+    int tamBloque;
+    atomic_int siguiente;          // primera fila aún sin repartir
+    int maxParticipantes;
+    int participantes;             // protegidos por pool.mutex
+    int activos;
+    int utilizados;
+    MetricasOperacion* metricas;   // del hilo que envió el trabajo (NULL = sin medir)
+    struct TrabajoFilas* sig;
+} TrabajoFilas;
+
+static struct {
+    pthread_t hilos[MAX_HILOS];
+    int numHilos;
+    int cerrando;
+    TrabajoFilas* cola;
+    pthread_mutex_t mutex;
+    pthread_cond_t hayTrabajo;
+    pthread_cond_t trabajoTerminado;
+} pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .hayTrabajo = PTHREAD_COND_INITIALIZER,
+    .trabajoTerminado = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t poolUnaVez = PTHREAD_ONCE_INIT;
+
+static int ejecutarBloques(TrabajoFilas* t, int hiloId) {
+    int procesados = 0;
+    double ocupado = 0.0;
+    LecturaContadores antes;
+    if (t->metricas && t->metricas->perfilHardware) leerContadoresHilo(&antes);
+    int trazar = trazando();
+    
+    for (;;) {
+        int inicio = atomic_fetch_add(&t->siguiente, t->tamBloque);
+        if (inicio >= t->total) break;
+        int fin = (inicio + t->tamBloque < t->total) ? inicio + t->tamBloque : t->total;
+        double t0 = (t->metricas || trazar) ? tiempoActual() : 0.0;
+        t->tarea(t->ctx, inicio, fin, hiloId);
+        if (t->metricas) ocupado += tiempoActual() - t0;
+        if (trazar) registrarTraza("filas", t->metricas ? t->metricas->nombre : "bloque", t0, inicio, fin, NULL);
+        procesados++;
+    }
+    
+    if (t->metricas && procesados > 0) {
+        t->metricas->ocupado[hiloId] += ocupado;
+        t->metricas->bloques[hiloId] += procesados;
+        if (t->metricas->perfilHardware) acumularContadores(t->metricas, hiloId, &antes);
+    }
+    return procesados;
+}
+
+// Requiere pool.mutex tomado.
+static void quitarTrabajoDeCola(TrabajoFilas* t) {
+    for (TrabajoFilas** p = &pool.cola; *p; p = &(*p)->sig) {
+        if (*p == t) {
+            *p = t->sig;
+            return;
+        }
+    }
+}
+
+// Requiere pool.mutex tomado.
+static TrabajoFilas* buscarTrabajoPendiente(void) {
+    for (TrabajoFilas* t = pool.cola; t; t = t->sig) {
+        if (t->participantes < t->maxParticipantes &&
+            atomic_load(&t->siguiente) < t->total) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static void* trabajadorPool(void* arg) {
+    char nombre[32];
+    snprintf(nombre, sizeof(nombre), "pool %d", (int)(intptr_t)arg);
+    nombrarHiloTraza(nombre);
+    pthread_mutex_lock(&pool.mutex);
+    
+    for (;;) {
+        TrabajoFilas* t;
+        while (!pool.cerrando && !(t = buscarTrabajoPendiente())) {
+            pthread_cond_wait(&pool.hayTrabajo, &pool.mutex);
+        }
+        if (pool.cerrando) break;
+        
+        int hiloId = t->participantes++;
+        t->activos++;
+        if (t->participantes >= t->maxParticipantes) quitarTrabajoDeCola(t);
+        pthread_mutex_unlock(&pool.mutex);
+        
+        int procesados = ejecutarBloques(t, hiloId);
+        
+        pthread_mutex_lock(&pool.mutex);
+        if (procesados > 0) t->utilizados++;
+        if (--t->activos == 0) pthread_cond_broadcast(&pool.trabajoTerminado);
+    }
+    
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+static void crearPoolHilos(void) {
+    // El hilo que envía cada trabajo también participa, así que bastan
+    // MAX_HILOS - 1 trabajadores para cubrir cualquier número de hilos.
+    for (int i = 0; i < MAX_HILOS - 1; i++) {
+        if (pthread_create(&pool.hilos[pool.numHilos], NULL, trabajadorPool, (void*)(intptr_t)(i + 1)) != 0) {
+            fprintf(stderr, "⚠ Advertencia: No se pudo crear hilo %d del pool\n", i);
+            break;
+        }
+        pool.numHilos++;
+    }
+}
+
+void iniciarPoolHilos(void) {
+    pthread_once(&poolUnaVez, crearPoolHilos);
+}
+
+void destruirPoolHilos(void) {
+    pthread_mutex_lock(&pool.mutex);
+    pool.cerrando = 1;
+    pthread_cond_broadcast(&pool.hayTrabajo);
+    pthread_mutex_unlock(&pool.mutex);
+    
+    for (int i = 0; i < pool.numHilos; i++) {
+        pthread_join(pool.hilos[i], NULL);
+    }
+    pool.numHilos = 0;
+}
+
+// Reparte las filas [0, total) entre hasta numHilos participantes del pool y
+// espera a que terminen. Una misma llamada puede entregar varios rangos al
+// mismo hiloId. Devuelve cuántos hilos procesaron alguna fila.
+int paraleloFilas(int total, int numHilos, TareaFilas tarea, void* ctx) {
+    if (total <= 0) return 0;
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    if (numHilos > total) numHilos = total;
+    
+    iniciarPoolHilos();
+    
+    MetricasOperacion* metricas = metricasHilo;
+    if (metricas) metricas->numTrabajos++;
+    
+    if (numHilos == 1 || pool.numHilos == 0) {
+        LecturaContadores antes;
+        if (metricas && metricas->perfilHardware) leerContadoresHilo(&antes);
+        double t0 = (metricas || trazando()) ? tiempoActual() : 0.0;
+        tarea(ctx, 0, total, 0);
+        registrarTraza("filas", metricas ? metricas->nombre : "bloque", t0, 0, total, NULL);
+        if (metricas) {
+            metricas->ocupado[0] += tiempoActual() - t0;
+            metricas->bloques[0]++;
+            if (metricas->perfilHardware) acumularContadores(metricas, 0, &antes);
+        }
+        return 1;
+    }
+    
+    TrabajoFilas t;
+    t.tarea = tarea;
+    t.ctx = ctx;
+    t.total = total;
+    // Planificación dinámica: las filas se reparten en trozos pequeños que
+    // cada participante toma del contador atómico compartido, de modo que
+    // las zonas caras de la imagen (p. ej. el centro de una rotación) no
+    // dejan a un solo hilo trabajando mientras los demás esperan.
+    int bloques = numHilos * BLOQUES_POR_HILO;
+    t.tamBloque = (total + bloques - 1) / bloques;
+    atomic_init(&t.siguiente, 0);
+    t.maxParticipantes = (numHilos < pool.numHilos + 1) ? numHilos : pool.numHilos + 1;
+    t.participantes = 1;
+    t.activos = 1;
+    t.utilizados = 0;
+    t.metricas = metricas;
+    
+    pthread_mutex_lock(&pool.mutex);
+    t.sig = pool.cola;
+    pool.cola = &t;
+    pthread_cond_broadcast(&pool.hayTrabajo);
+    pthread_mutex_unlock(&pool.mutex);
+    
+    int procesados = ejecutarBloques(&t, 0);
+    
+    pthread_mutex_lock(&pool.mutex);
+    if (procesados > 0) t.utilizados++;
+    t.activos--;
+    quitarTrabajoDeCola(&t);
+    while (t.activos > 0) {
+        pthread_cond_wait(&pool.trabajoTerminado, &pool.mutex);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    
+    return t.utilizados;
+}
+
+// ============================================================================
+// CODIFICADOR PNG PARALELO
+// ============================================================================
+
+// La imagen se divide en tiras de filas. Cada tira se filtra (eligiendo el
+// filtro PNG de cada fila) y se comprime con deflate de forma independiente
+// en el pool; las tiras intermedias terminan con un bloque almacenado vacío
+// (sync flush) para quedar alineadas a byte, así que sus flujos se pueden
+// concatenar tal cual en un único flujo zlib válido. Cada tira se escribe
+// como un chunk IDAT con su propio CRC y el Adler-32 global se obtiene
+// combinando los de cada tira.
+
+#define PNG_HASH_BITS 15
+#define PNG_VENTANA 32768
+#define PNG_MIN_BYTES_TIRA (256 * 1024)
+
+#define NIVEL_PNG_DEFECTO 6
+#define FILTRO_PNG_ADAPTATIVO -1
+
+typedef struct {
+    int cadenaMax;          // candidatos a revisar por posición
+    int largoSuficiente;    // coincidencia que detiene la búsqueda
+    int perezoso;           // evaluación perezosa (mira una posición más)
+    int largoInsercion;     // en coincidencias más largas no se indexan las posiciones internas
+} ParamsDeflate;
+
+// Nivel 0: bloques almacenados sin comprimir; 1-3: búsqueda corta y voraz;
+// 4-9: evaluación perezosa con cadenas cada vez más largas.
+static const ParamsDeflate paramsNivelDeflate[10] = {
+    {0, 0, 0, 0},
+    {4, 16, 0, 8},
+    {8, 32, 0, 16},
+    {16, 64, 0, 32},
+    {32, 64, 1, 258},
+    {64, 128, 1, 258},
+    {128, 128, 1, 258},
+    {256, 258, 1, 258},
+    {1024, 258, 1, 258},
+    {4096, 258, 1, 258},
+};
+
+// Opciones de guardado PNG: nivel de compresión (0-9) y filtro de fila
+// (FILTRO_PNG_ADAPTATIVO o un tipo fijo 0-4).
+typedef struct {
+    int nivel;
+    int filtro;
+} OpcionesPNG;
+
+static const char* nombresFiltroPNG[5] = {"none", "sub", "up", "average", "paeth"};
+
+static uint32_t tablaCRC[8][256];     // slicing-by-8
+static uint16_t codigoLiteral[288];     // códigos Huffman fijos ya invertidos
+static uint8_t bitsLiteral[288];
+static uint32_t codigoLargo[259];       // símbolo + bits extra, por longitud
+static uint8_t bitsLargo[259];
+static uint8_t simboloDist[512];
+static pthread_once_t tablasPNGUnaVez = PTHREAD_ONCE_INIT;
+
+static const uint16_t baseLargoDeflate[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t extraLargoDeflate[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t baseDistDeflate[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t extraDistDeflate[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t invertirBits(uint32_t codigo, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; i++) {
+        r = (r << 1) | (codigo & 1);
+        codigo >>= 1;
+    }
+    return r;
+}
+
+static void crearTablasPNG(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        tablaCRC[0][n] = c;
+    }
+    for (int t = 1; t < 8; t++) {
+        for (int n = 0; n < 256; n++) {
+            tablaCRC[t][n] = tablaCRC[0][tablaCRC[t - 1][n] & 0xFF] ^ (tablaCRC[t - 1][n] >> 8);
+        }
+    }
+    
+    // Huffman fijo de deflate (RFC 1951, 3.2.6)
+    for (int s = 0; s < 288; s++) {
+        uint32_t codigo;
+        int n;
+        if (s < 144)      { codigo = 0x30 + s;          n = 8; }
+        else if (s < 256) { codigo = 0x190 + (s - 144); n = 9; }
+        else if (s < 280) { codigo = s - 256;           n = 7; }
+        else              { codigo = 0xC0 + (s - 280);  n = 8; }
+        codigoLiteral[s] = (uint16_t)invertirBits(codigo, n);
+        bitsLiteral[s] = (uint8_t)n;
+    }
+    
+    for (int s = 0; s < 29; s++) {
+        int fin = (s == 28) ? 258 : baseLargoDeflate[s] + (1 << extraLargoDeflate[s]) - 1;
+        for (int largo = baseLargoDeflate[s]; largo <= fin; largo++) {
+            int sim = 257 + s;
+            codigoLargo[largo] = codigoLiteral[sim] |
+                                 ((uint32_t)(largo - baseLargoDeflate[s]) << bitsLiteral[sim]);
+            bitsLargo[largo] = (uint8_t)(bitsLiteral[sim] + extraLargoDeflate[s]);
+        }
+    }
+    
+    for (int s = 0; s < 30; s++) {
+        int fin = baseDistDeflate[s] + (1 << extraDistDeflate[s]) - 1;
+        for (int d = baseDistDeflate[s]; d <= fin; d++) {
+            int idx = (d - 1 < 256) ? d - 1 : 256 + ((d - 1) >> 7);
+            simboloDist[idx] = (uint8_t)s;
+        }
+    }
+}
+
+uint32_t actualizarCRC(uint32_t crc, const unsigned char* datos, size_t n) {
+    crc = ~crc;
+    // Slicing-by-8: ocho bytes por iteración con una tabla por posición
+    while (n >= 8) {
+        uint32_t lo = crc ^ ((uint32_t)datos[0] | ((uint32_t)datos[1] << 8) |
+                             ((uint32_t)datos[2] << 16) | ((uint32_t)datos[3] << 24));
+        crc = tablaCRC[7][lo & 0xFF] ^ tablaCRC[6][(lo >> 8) & 0xFF] ^
+              tablaCRC[5][(lo >> 16) & 0xFF] ^ tablaCRC[4][lo >> 24] ^
+              tablaCRC[3][datos[4]] ^ tablaCRC[2][datos[5]] ^
+              tablaCRC[1][datos[6]] ^ tablaCRC[0][datos[7]];
+        datos += 8;
+        n -= 8;
+    }
+    while (n-- > 0) crc = tablaCRC[0][(crc ^ *datos++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#define ADLER_BASE 65521u
+
+uint32_t actualizarAdler32(uint32_t adler, const unsigned char* datos, size_t n) {
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    while (n > 0) {
+        // 5552 es el mayor bloque que no desborda b antes del módulo
+        size_t bloque = n < 5552 ? n : 5552;
+        n -= bloque;
+        for (size_t i = 0; i < bloque; i++) {
+            a += datos[i];
+            b += a;
+        }
+        datos += bloque;
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return a | (b << 16);
+}
+
+// Adler-32 de A||B a partir de los de A y B y la longitud de B (como
+// adler32_combine de zlib).
+uint32_t combinarAdler32(uint32_t adler1, uint32_t adler2, size_t largo2) {
+    uint32_t resto = (uint32_t)(largo2 % ADLER_BASE);
+    uint64_t suma1 = adler1 & 0xFFFF;
+    uint64_t suma2 = ((uint64_t)resto * suma1) % ADLER_BASE;
+    suma1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    suma2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - resto;
+    if (suma1 >= ADLER_BASE) suma1 -= ADLER_BASE;
+    if (suma1 >= ADLER_BASE) suma1 -= ADLER_BASE;
+    if (suma2 >= 2 * (uint64_t)ADLER_BASE) suma2 -= 2 * (uint64_t)ADLER_BASE;
+    if (suma2 >= ADLER_BASE) suma2 -= ADLER_BASE;
+    return (uint32_t)(suma1 | (suma2 << 16));
+}
+
+// Escritor de bits LSB primero sobre un buffer ya dimensionado para el peor caso
+typedef struct {
+    unsigned char* datos;
+    size_t tam;
+    uint64_t acumulador;
+    int numBits;
+} EscritorBits;
+
+static inline void escribirBits(EscritorBits* e, uint32_t bits, int n) {
+    e->acumulador |= (uint64_t)bits << e->numBits;
+    e->numBits += n;
+    if (e->numBits >= 32) {
+        unsigned char* p = e->datos + e->tam;
+        p[0] = (unsigned char)e->acumulador;
+        p[1] = (unsigned char)(e->acumulador >> 8);
+        p[2] = (unsigned char)(e->acumulador >> 16);
+        p[3] = (unsigned char)(e->acumulador >> 24);
+        e->tam += 4;
+        e->acumulador >>= 32;
+        e->numBits -= 32;
+    }
+}
+
+static void alinearBits(EscritorBits* e) {
+    while (e->numBits > 0) {
+        e->datos[e->tam++] = (unsigned char)e->acumulador;
+        e->acumulador >>= 8;
+        e->numBits -= 8;
+    }
+    e->acumulador = 0;
+    e->numBits = 0;
+}
+
+// Bloque almacenado vacío: deja el flujo alineado a byte sin terminarlo
+static void escribirSyncFlush(EscritorBits* e) {
+    escribirBits(e, 0, 3);      // BFINAL = 0, BTYPE = 00
+    alinearBits(e);
+    e->datos[e->tam++] = 0x00;
+    e->datos[e->tam++] = 0x00;
+    e->datos[e->tam++] = 0xFF;
+    e->datos[e->tam++] = 0xFF;
+}
+
+static inline uint32_t hashDeflate(const unsigned char* p) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (v * 2654435761u) >> (32 - PNG_HASH_BITS);
+}
+
+static inline int largoCoincidencia(const unsigned char* a, const unsigned char* b, int max) {
+    int l = 0;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (l + 8 <= max) {
+        uint64_t x, y;
+        memcpy(&x, a + l, 8);
+        memcpy(&y, b + l, 8);
+        if (x != y) return l + (__builtin_ctzll(x ^ y) >> 3);
+        l += 8;
+    }
+#endif
+    while (l < max && a[l] == b[l]) l++;
+    return l;
+}
+
+// Busca la coincidencia más larga para la posición i recorriendo la cadena
+// de su hash. Devuelve la longitud (0 si es menor que 3) y deja la distancia.
+static inline int buscarCoincidencia(const unsigned char* in, size_t n, size_t i, const int32_t* cabeza,
+                                     const int32_t* previo, const ParamsDeflate* prm, int* dist) {
+    if (i + 3 > n) return 0;
+    int max = (n - i < 258) ? (int)(n - i) : 258;
+    int32_t limite = (i > PNG_VENTANA) ? (int32_t)(i - PNG_VENTANA) : 0;
+    int32_t cand = cabeza[hashDeflate(in + i)];
+    int mejor = 2, cadena = prm->cadenaMax;
+    
+    while (cand >= limite && cadena-- > 0) {
+        const unsigned char* c = in + cand;
+        if (c[mejor] == in[i + mejor] && c[0] == in[i]) {
+            int l = largoCoincidencia(c, in + i, max);
+            if (l > mejor) {
+                mejor = l;
+                *dist = (int)(i - cand);
+                if (l >= max || l >= prm->largoSuficiente) break;
+            }
+        }
+        int32_t sig = previo[cand & (PNG_VENTANA - 1)];
+        if (sig >= cand) break;
+        cand = sig;
+    }
+    return mejor >= 3 ? mejor : 0;
+}
+
+static inline void insertarHash(const unsigned char* in, size_t n, size_t i, int32_t* cabeza, int32_t* previo) {
+    if (i + 3 > n) return;
+    uint32_t h = hashDeflate(in + i);
+    previo[i & (PNG_VENTANA - 1)] = cabeza[h];
+    cabeza[h] = (int32_t)i;
+}
+
+static inline void emitirLiteral(EscritorBits* e, unsigned char v) {
+    escribirBits(e, codigoLiteral[v], bitsLiteral[v]);
+}
+
+static inline void emitirCoincidencia(EscritorBits* e, int largo, int dist) {
+    escribirBits(e, codigoLargo[largo], bitsLargo[largo]);
+    int s = simboloDist[(dist - 1 < 256) ? dist - 1 : 256 + ((dist - 1) >> 7)];
+    escribirBits(e, invertirBits((uint32_t)s, 5) | ((uint32_t)(dist - baseDistDeflate[s]) << 5),
+                 5 + extraDistDeflate[s]);
+}
+
+// Comprime in[0, n) como un bloque deflate con Huffman fijo. cabeza y previo
+// son las tablas de hash del llamador (se reinician aquí).
+static void comprimirDeflate(const unsigned char* in, size_t n, int final, const ParamsDeflate* prm,
+                             EscritorBits* e, int32_t* cabeza, int32_t* previo) {
+    for (int i = 0; i < (1 << PNG_HASH_BITS); i++) cabeza[i] = -1;
+    
+    escribirBits(e, final ? 1 : 0, 1);
+    escribirBits(e, 1, 2);      // BTYPE = 01 (Huffman fijo)
+    
+    size_t i = 0;
+    int largoSig = 0, distSig = 0, haySig = 0;
+    while (i < n) {
+        int dist = 0;
+        int largo = haySig ? largoSig : buscarCoincidencia(in, n, i, cabeza, previo, prm, &dist);
+        if (haySig) dist = distSig;
+        haySig = 0;
+        insertarHash(in, n, i, cabeza, previo);
+        
+        // Evaluación perezosa: si la siguiente posición da algo mejor, se
+        // emite un literal y se aprovecha esa coincidencia.
+        if (largo && prm->perezoso && largo < prm->largoSuficiente) {
+            largoSig = buscarCoincidencia(in, n, i + 1, cabeza, previo, prm, &distSig);
+            if (largoSig > largo) {
+                emitirLiteral(e, in[i]);
+                i++;
+                haySig = 1;
+                continue;
+            }
+        }
+        
+        if (largo) {
+            emitirCoincidencia(e, largo, dist);
+            if (largo <= prm->largoInsercion) {
+                for (int k = 1; k < largo; k++) insertarHash(in, n, i + k, cabeza, previo);
+            }
+            i += largo;
+        } else {
+            emitirLiteral(e, in[i]);
+            i++;
+        }
+    }
+    
+    escribirBits(e, codigoLiteral[256], bitsLiteral[256]);     // fin de bloque
+}
+
+// Nivel 0: in[0, n) en bloques almacenados de hasta 65535 bytes. Cada
+// bloque termina alineado a byte, así que no hace falta sync flush.
+static void almacenarDeflate(const unsigned char* in, size_t n, int final, EscritorBits* e) {
+    do {
+        size_t largo = n < 65535 ? n : 65535;
+        n -= largo;
+        escribirBits(e, (final && n == 0) ? 1 : 0, 3);      // BTYPE = 00
+        alinearBits(e);
+        e->datos[e->tam++] = (unsigned char)largo;
+        e->datos[e->tam++] = (unsigned char)(largo >> 8);
+        e->datos[e->tam++] = (unsigned char)~largo;
+        e->datos[e->tam++] = (unsigned char)(~largo >> 8);
+        memcpy(e->datos + e->tam, in, largo);
+        e->tam += largo;
+        in += largo;
+    } while (n > 0);
+}
+
+static inline int predictorPaeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return (pb <= pc) ? b : c;
+}
+
+#if defined(__SSE2__)
+// Paeth de 8 bytes en carriles de 16 bits: a izquierda, b arriba, c arriba-izquierda
+static inline __m128i predictorPaethSSE2(__m128i a, __m128i b, __m128i c) {
+    __m128i cero = _mm_setzero_si128();
+    __m128i pa = _mm_sub_epi16(b, c);                  // p - a
+    __m128i pb = _mm_sub_epi16(a, c);                  // p - b
+    __m128i pc = _mm_add_epi16(pa, pb);                // p - c
+    pa = _mm_max_epi16(pa, _mm_sub_epi16(cero, pa));
+    pb = _mm_max_epi16(pb, _mm_sub_epi16(cero, pb));
+    pc = _mm_max_epi16(pc, _mm_sub_epi16(cero, pc));
+    __m128i usaA = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc)),
+                                    _mm_set1_epi16(-1));
+    __m128i usaB = _mm_andnot_si128(_mm_cmpgt_epi16(pb, pc), _mm_set1_epi16(-1));
+    __m128i bc = _mm_or_si128(_mm_and_si128(usaB, b), _mm_andnot_si128(usaB, c));
+    return _mm_or_si128(_mm_and_si128(usaA, a), _mm_andnot_si128(usaA, bc));
+}
+#endif
+
+// Aplica el filtro PNG 'tipo' (0..4) a una fila; previa es la fila anterior
+// sin filtrar (ceros en la primera fila de la imagen). Cada byte depende
+// sólo de la entrada sin filtrar, así que los bucles vectorizan sin arrastre.
+static void filtrarFilaPNG(int tipo, const unsigned char* fila, const unsigned char* previa,
+                           size_t n, int bpp, unsigned char* out) {
+    size_t i = 0;
+    switch (tipo) {
+        case 0:
+            memcpy(out, fila, n);
+            break;
+        case 1:
+            for (; i < (size_t)bpp; i++) out[i] = fila[i];
+#if defined(__SSE2__)
+            for (; i + 16 <= n; i += 16) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(fila + i));
+                __m128i a = _mm_loadu_si128((const __m128i*)(fila + i - bpp));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, a));
+            }
+#endif
+            for (; i < n; i++) out[i] = (unsigned char)(fila[i] - fila[i - bpp]);
+            break;
+        case 2:
+#if defined(__SSE2__)
+            for (; i + 16 <= n; i += 16) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(fila + i));
+                __m128i b = _mm_loadu_si128((const __m128i*)(previa + i));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, b));
+            }
+#endif
+            for (; i < n; i++) out[i] = (unsigned char)(fila[i] - previa[i]);
+            break;
+        case 3:
+            for (; i < (size_t)bpp; i++) out[i] = (unsigned char)(fila[i] - (previa[i] >> 1));
+#if defined(__SSE2__)
+            for (; i + 16 <= n; i += 16) {
+                __m128i x = _mm_loadu_si128((const __m128i*)(fila + i));
+                __m128i a = _mm_loadu_si128((const __m128i*)(fila + i - bpp));
+                __m128i b = _mm_loadu_si128((const __m128i*)(previa + i));
+                // pavgb redondea hacia arriba; se corrige restando el bit bajo de a^b
+                __m128i media = _mm_sub_epi8(_mm_avg_epu8(a, b),
+                                             _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, media));
+            }
+#endif
+            for (; i < n; i++) out[i] = (unsigned char)(fila[i] - ((fila[i - bpp] + previa[i]) >> 1));
+            break;
+        default:
+            for (; i < (size_t)bpp; i++) out[i] = (unsigned char)(fila[i] - previa[i]);
+#if defined(__SSE2__)
+            for (; i + 16 <= n; i += 16) {
+                __m128i cero = _mm_setzero_si128();
+                __m128i x = _mm_loadu_si128((const __m128i*)(fila + i));
+                __m128i a = _mm_loadu_si128((const __m128i*)(fila + i - bpp));
+                __m128i b = _mm_loadu_si128((const __m128i*)(previa + i));
+                __m128i c = _mm_loadu_si128((const __m128i*)(previa + i - bpp));
+                __m128i bajo = predictorPaethSSE2(_mm_unpacklo_epi8(a, cero), _mm_unpacklo_epi8(b, cero),
+                                                  _mm_unpacklo_epi8(c, cero));
+                __m128i alto = predictorPaethSSE2(_mm_unpackhi_epi8(a, cero), _mm_unpackhi_epi8(b, cero),
+                                                  _mm_unpackhi_epi8(c, cero));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi8(x, _mm_packus_epi16(bajo, alto)));
+            }
+#endif
+            for (; i < n; i++) {
+                out[i] = (unsigned char)(fila[i] - predictorPaeth(fila[i - bpp], previa[i], previa[i - bpp]));
+            }
+            break;
+    }
+}
+
+// Suma de |byte con signo| de una fila filtrada
+static uint64_t sumaAbsFila(const unsigned char* out, size_t n) {
+    uint64_t suma = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i cero = _mm_setzero_si128();
+    __m128i acum = cero;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(out + i));
+        // |s| = min(u, -u) leyendo ambos como sin signo
+        __m128i absV = _mm_min_epu8(v, _mm_sub_epi8(cero, v));
+        acum = _mm_add_epi64(acum, _mm_sad_epu8(absV, cero));
+    }
+    uint64_t parciales[2];
+    _mm_storeu_si128((__m128i*)parciales, acum);
+    suma = parciales[0] + parciales[1];
+#endif
+    for (; i < n; i++) suma += (uint64_t)abs((int)(signed char)out[i]);
+    return suma;
+}
+
+// Heurística habitual (libpng, stb): el filtro cuya salida, leída como bytes
+// con signo, tiene la menor suma de valores absolutos.
+static int elegirFiltroPNG(const unsigned char* fila, const unsigned char* previa, size_t n, int bpp,
+                           unsigned char* candidatos) {
+    int mejor = 0;
+    uint64_t mejorSuma = UINT64_MAX;
+    for (int tipo = 0; tipo < 5; tipo++) {
+        unsigned char* out = candidatos + (size_t)tipo * n;
+        filtrarFilaPNG(tipo, fila, previa, n, bpp, out);
+        uint64_t suma = sumaAbsFila(out, n);
+        if (suma < mejorSuma) {
+            mejorSuma = suma;
+            mejor = tipo;
+        }
+    }
+    return mejor;
+}
+
+typedef struct {
+    unsigned char* datos;       // flujo deflate de la tira (con cabecera zlib en la primera)
+    size_t tam;
+    size_t tamCrudo;            // bytes filtrados que comprime
+    uint32_t adler;
+    uint32_t crc;               // CRC del chunk IDAT ("IDAT" + datos)
+} TiraPNG;
+
+typedef struct {
+    const ImagenInfo* info;
+    int filasPorTira;
+    int numTiras;
+    int nivel;
+    int filtro;
+    TiraPNG* tiras;
+    atomic_int errores;
+} CodificadorPNGArgs;
+
+void codificarTirasHilo(void* arg, int inicio, int fin, int hiloId) {
+    CodificadorPNGArgs* a = (CodificadorPNGArgs*)arg;
+    const ImagenInfo* info = a->info;
+    size_t n = (size_t)info->ancho * info->canales;
+    size_t maxCrudo = (size_t)a->filasPorTira * (n + 1);
+    (void)hiloId;
+    
+    unsigned char* crudo = (unsigned char*)malloc(maxCrudo);
+    unsigned char* candidatos = (unsigned char*)malloc(5 * n);
+    unsigned char* ceros = (unsigned char*)calloc(n, 1);
+    int32_t* cabeza = (int32_t*)malloc(sizeof(int32_t) << PNG_HASH_BITS);
+    int32_t* previo = (int32_t*)malloc(sizeof(int32_t) * PNG_VENTANA);
+    
+    for (int t = inicio; t < fin; t++) {
+        TiraPNG* tira = &a->tiras[t];
+        if (!crudo || !candidatos || !ceros || !cabeza || !previo) {
+            atomic_fetch_add(&a->errores, 1);
+            continue;
+        }
+        
+        int y0 = t * a->filasPorTira;
+        int y1 = (y0 + a->filasPorTira < info->alto) ? y0 + a->filasPorTira : info->alto;
+        size_t tamCrudo = 0;
+        
+        for (int y = y0; y < y1; y++) {
+            const unsigned char* fila = filaPixeles(info, y);
+            const unsigned char* previa = (y > 0) ? filaPixeles(info, y - 1) : ceros;
+            if (a->filtro == FILTRO_PNG_ADAPTATIVO) {
+                int tipo = elegirFiltroPNG(fila, previa, n, info->canales, candidatos);
+                crudo[tamCrudo++] = (unsigned char)tipo;
+                memcpy(crudo + tamCrudo, candidatos + (size_t)tipo * n, n);
+            } else {
+                crudo[tamCrudo++] = (unsigned char)a->filtro;
+                filtrarFilaPNG(a->filtro, fila, previa, n, info->canales, crudo + tamCrudo);
+            }
+            tamCrudo += n;
+        }
+        
+        // Peor caso: 9 bits por literal con Huffman fijo o 5 bytes de
+        // cabecera por bloque almacenado, más cabeceras y sync flush
+        size_t cota = tamCrudo + tamCrudo / 8 + 64;
+        tira->datos = (unsigned char*)malloc(cota);
+        if (!tira->datos) {
+            atomic_fetch_add(&a->errores, 1);
+            continue;
+        }
+        
+        EscritorBits e = {tira->datos, 0, 0, 0};
+        if (t == 0) {
+            // CMF: deflate con ventana de 32 KB; FLG: nivel orientativo
+            // (rápido, normal, por defecto, máximo) y múltiplo de 31
+            static const unsigned char flg[4] = {0x01, 0x5E, 0x9C, 0xDA};
+            int clase = a->nivel <= 1 ? 0 : (a->nivel <= 5 ? 1 : (a->nivel == 6 ? 2 : 3));
+            tira->datos[e.tam++] = 0x78;
+            tira->datos[e.tam++] = flg[clase];
+        }
+        
+        int final = (t == a->numTiras - 1);
+        if (a->nivel == 0) {
+            almacenarDeflate(crudo, tamCrudo, final, &e);
+        } else {
+            size_t inicioBloque = e.tam;
+            comprimirDeflate(crudo, tamCrudo, final, &paramsNivelDeflate[a->nivel], &e, cabeza, previo);
+            if (final) {
+                alinearBits(&e);
+            } else {
+                escribirSyncFlush(&e);
+            }
+            
+            // Datos de alta entropía: con Huffman fijo la tira crecería, así
+            // que (como zlib) se reescribe en bloques almacenados si ocupan
+            // lo mismo o menos. El escritor estaba alineado al empezar.
+            size_t almacenado = tamCrudo + 5 * ((tamCrudo + 65534) / 65535 + (tamCrudo == 0));
+            if (almacenado <= e.tam - inicioBloque) {
+                e.tam = inicioBloque;
+                e.acumulador = 0;
+                e.numBits = 0;
+                almacenarDeflate(crudo, tamCrudo, final, &e);
+            }
+        }
+        
+        tira->tam = e.tam;
+        tira->tamCrudo = tamCrudo;
+        tira->adler = actualizarAdler32(1, crudo, tamCrudo);
+        tira->crc = actualizarCRC(actualizarCRC(0, (const unsigned char*)"IDAT", 4), tira->datos, tira->tam);
+    }
+    
+    free(crudo);
+    free(candidatos);
+    free(ceros);
+    free(cabeza);
+    free(previo);
+}
+
+static void escribirU32BE(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static int escribirChunkPNG(FILE* f, const char* tipo, const unsigned char* datos, size_t tam, uint32_t crc) {
+    unsigned char cab[8], pie[4];
+    escribirU32BE(cab, (uint32_t)tam);
+    memcpy(cab + 4, tipo, 4);
+    escribirU32BE(pie, crc);
+    return fwrite(cab, 1, 8, f) == 8 &&
+           (tam == 0 || fwrite(datos, 1, tam, f) == tam) &&
+           fwrite(pie, 1, 4, f) == 4;
+}
+
+static uint32_t crcChunk(const char* tipo, const unsigned char* datos, size_t tam) {
+    return actualizarCRC(actualizarCRC(0, (const unsigned char*)tipo, 4), datos, tam);
+}
+
+// Resultado de codificar una imagen: los chunks IDAT de cada tira
+typedef struct {
+    TiraPNG* tiras;
+    int numTiras;
+    uint32_t adler;             // Adler-32 del flujo zlib completo
+    int hilosUsados;
+} PNGCodificado;
+
+void liberarPNGCodificado(PNGCodificado* png) {
+    if (!png->tiras) return;
+    for (int t = 0; t < png->numTiras; t++) free(png->tiras[t].datos);
+    free(png->tiras);
+    png->tiras = NULL;
+}
+
+// Tamaño del archivo resultante: firma, IHDR, un IDAT por tira, el IDAT del
+// Adler-32 e IEND.
+size_t tamArchivoPNG(const PNGCodificado* png) {
+    size_t tam = 8 + (12 + 13) + (12 + 4) + 12;
+    for (int t = 0; t < png->numTiras; t++) tam += 12 + png->tiras[t].tam;
+    return tam;
+}
+
+// Filtra y comprime las tiras de la imagen en paralelo. Devuelve 1 si todo
+// fue bien; si falla no queda memoria reservada en png.
+int codificarPNG(const ImagenInfo* info, const OpcionesPNG* opciones, int numHilos, PNGCodificado* png) {
+    pthread_once(&tablasPNGUnaVez, crearTablasPNG);
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    
+    // Varias tiras por hilo para equilibrar la carga, pero no tan pequeñas
+    // que el reinicio de la ventana de deflate empeore la compresión.
+    size_t bytesFila = (size_t)info->ancho * info->canales + 1;
+    int filasMin = (int)((PNG_MIN_BYTES_TIRA + bytesFila - 1) / bytesFila);
+    int filasPorTira = (info->alto + numHilos * 4 - 1) / (numHilos * 4);
+    if (filasPorTira < filasMin) filasPorTira = filasMin;
+    if (filasPorTira > info->alto) filasPorTira = info->alto;
+    
+    CodificadorPNGArgs args;
+    args.info = info;
+    args.filasPorTira = filasPorTira;
+    args.numTiras = (info->alto + filasPorTira - 1) / filasPorTira;
+    args.nivel = (opciones->nivel < 0) ? 0 : (opciones->nivel > 9 ? 9 : opciones->nivel);
+    args.filtro = (opciones->filtro >= 0 && opciones->filtro <= 4) ? opciones->filtro : FILTRO_PNG_ADAPTATIVO;
+    args.tiras = (TiraPNG*)calloc((size_t)args.numTiras, sizeof(TiraPNG));
+    atomic_init(&args.errores, 0);
+    if (!args.tiras) return 0;
+    
+    png->tiras = args.tiras;
+    png->numTiras = args.numTiras;
+    png->hilosUsados = paraleloFilas(args.numTiras, numHilos, codificarTirasHilo, &args);
+    
+    if (atomic_load(&args.errores) != 0) {
+        liberarPNGCodificado(png);
+        return 0;
+    }
+    
+    png->adler = 1;
+    for (int t = 0; t < png->numTiras; t++) {
+        png->adler = combinarAdler32(png->adler, png->tiras[t].adler, png->tiras[t].tamCrudo);
+    }
+    return 1;
+}
+
+// Escribe la imagen como PNG de 8 bits comprimiendo las tiras en paralelo.
+// Devuelve el número de hilos utilizados, 0 si no hubo memoria para
+// codificar o -1 si falló la escritura (con errno del fallo); en ningún
+// caso deja un archivo a medias.
+int escribirPNGParalelo(const ImagenInfo* info, const char* ruta, const OpcionesPNG* opciones, int numHilos) {
+    static const unsigned char firma[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    static const unsigned char tiposColor[5] = {0, 0, 4, 2, 6};
+    
+    PNGCodificado png;
+    double tTraza = inicioTraza();
+    int codificado = codificarPNG(info, opciones, numHilos, &png);
+    registrarTraza("es", "codificar PNG", tTraza, -1, -1, ruta);
+    if (!codificado) return 0;
+    
+    tTraza = inicioTraza();
+    FILE* f = fopen(ruta, "wb");
+    int ok = f != NULL;
+    int error = f ? 0 : errno;
+    if (f) {
+        unsigned char ihdr[13];
+        escribirU32BE(ihdr, (uint32_t)info->ancho);
+        escribirU32BE(ihdr + 4, (uint32_t)info->alto);
+        ihdr[8] = 8;                            // bits por muestra
+        ihdr[9] = tiposColor[info->canales];
+        ihdr[10] = ihdr[11] = ihdr[12] = 0;     // deflate, filtro adaptativo, sin entrelazado
+        
+        ok = fwrite(firma, 1, 8, f) == 8 && escribirChunkPNG(f, "IHDR", ihdr, 13, crcChunk("IHDR", ihdr, 13));
+        for (int t = 0; t < png.numTiras && ok; t++) {
+            ok = escribirChunkPNG(f, "IDAT", png.tiras[t].datos, png.tiras[t].tam, png.tiras[t].crc);
+        }
+        
+        // El Adler-32 final del flujo zlib va en un último IDAT de 4 bytes
+        unsigned char adlerBE[4];
+        escribirU32BE(adlerBE, png.adler);
+        ok = ok && escribirChunkPNG(f, "IDAT", adlerBE, 4, crcChunk("IDAT", adlerBE, 4));
+        ok = ok && escribirChunkPNG(f, "IEND", NULL, 0, crcChunk("IEND", NULL, 0));
+        if (!ok) error = errno;
+        if (fclose(f) != 0 && ok) {
+            error = errno;
+            ok = 0;
+        }
+        // Solo se borra un archivo normal a medias, nunca p. ej. un dispositivo
+        struct stat st;
+        if (!ok && stat(ruta, &st) == 0 && S_ISREG(st.st_mode)) remove(ruta);
+    }
+    
+    registrarTraza("es", "escribir PNG", tTraza, -1, -1, ruta);
+    
+    int hilosUsados = png.hilosUsados;
+    liberarPNGCodificado(&png);
+    errno = error;
+    return ok ? hilosUsados : -1;
+}
+
+// ============================================================================
+// CARGA Y GUARDADO DE IMÁGENES
+// ============================================================================
+
+// Decodifica la imagen una sola vez: primero se consulta la cabecera con
+// stbi_info para decidir los canales de salida y stb_image hace la
+// conversión durante la única decodificación. Con conservarAlfa las
+// imágenes con transparencia mantienen su canal alfa (2 ó 4 canales); sin
+// él se convierten a RGB como hasta ahora.
+int cargarImagen(const char* ruta, ImagenInfo* info, int conservarAlfa) {
+    if (!ruta || !info) {
+        fprintf(stderr, "❌ Error: Parámetros inválidos\n");
+        return 0;
+    }
+    
+    printf("📂 Cargando imagen: %s...\n", ruta);
+    
+    int orig_channels = 0;
+    int w = 0, h = 0;
+    double tTraza = inicioTraza();
+    if (!stbi_info(ruta, &w, &h, &orig_channels)) {
+        fprintf(stderr, "❌ Error: No se pudo cargar la imagen '%s'\n", ruta);
+        fprintf(stderr, "   Verifica que el archivo existe y es un formato válido (PNG, JPG, BMP, etc.)\n");
+        return 0;
+    }
+    
+    int desired = orig_channels;
+    if (!conservarAlfa && orig_channels != 1 && orig_channels != 3) {
+        desired = 3;
+    }
+    
+    int canalesArchivo = 0;
+    unsigned char* datos = stbi_load(ruta, &w, &h, &canalesArchivo, desired);
+    registrarTraza("es", "decodificar", tTraza, -1, -1, ruta);
+    
+    if (!datos) {
+        fprintf(stderr, "❌ Error: No se pudo decodificar la imagen '%s' (%s)\n", ruta, stbi_failure_reason());
+        return 0;
+    }
+    
+    printf("   Dimensiones: %dx%d píxeles\n", w, h);
+    if (canalesArchivo != desired) {
+        printf("   Canales: %d (%s), convertidos desde %d\n", desired, nombreCanales(desired), canalesArchivo);
+    } else {
+        printf("   Canales: %d (%s)\n", desired, nombreCanales(desired));
+    }
+    
+    // La imagen adopta el buffer del decodificador (filas empaquetadas, sin
+    // relleno): sin segunda reserva ni copia. stb_image reserva con malloc,
+    // así que liberarImagen puede devolverlo con free.
+    info->ancho = w;
+    info->alto = h;
+    info->canales = desired;
+    info->stride = (size_t)w * (size_t)desired;
+    info->pixeles = datos;
+    
+    printf("✓ Imagen cargada exitosamente\n");
+    return 1;
+}
+
+// opciones puede ser NULL (nivel por defecto y filtro adaptativo).
+int guardarPNG(const ImagenInfo* info, const char* rutaSalida, const OpcionesPNG* opciones, int numHilos) {
+    if (!info || !rutaSalida) {
+        fprintf(stderr, "❌ Error: Parámetros inválidos\n");
+        return 0;
+    }
+    
+    if (!info->pixeles) {
+        fprintf(stderr, "❌ Error: No hay imagen cargada para guardar\n");
+        return 0;
+    }
+    
+    if (info->ancho <= 0 || info->alto <= 0 || info->canales <= 0 || info->canales > 4) {
+        fprintf(stderr, "❌ Error: Dimensiones de imagen inválidas (%dx%d, %d canales)\n", 
+                info->ancho, info->alto, info->canales);
+        return 0;
+    }
+    
+    printf("💾 Guardando imagen: %s\n", rutaSalida);
+    printf("   Dimensiones: %dx%d, %d canales\n", info->ancho, info->alto, info->canales);
+    
+    OpcionesPNG porDefecto = {NIVEL_PNG_DEFECTO, FILTRO_PNG_ADAPTATIVO};
+    if (!opciones) opciones = &porDefecto;
+    printf("   Compresión: nivel %d, filtro %s\n", opciones->nivel,
+           opciones->filtro == FILTRO_PNG_ADAPTATIVO ? "adaptativo" : nombresFiltroPNG[opciones->filtro]);
+    
+    // Codificador propio: filtrado y deflate por tiras en el pool
+    int hilosUsados = escribirPNGParalelo(info, rutaSalida, opciones, numHilos);
+    if (hilosUsados > 0) {
+        printf("✓ Imagen guardada exitosamente (%d hilos utilizados)\n", hilosUsados);
+        return 1;
+    }
+    if (hilosUsados < 0) {
+        fprintf(stderr, "❌ Error: No se pudo escribir '%s': %s\n", rutaSalida, strerror(errno));
+        return 0;
+    }
+    
+    // Solo si faltó memoria para las tiras: el codificador secuencial de
+    // stb_image_write necesita menos a la vez.
+    printf("⚠ Memoria insuficiente para el codificador paralelo, se usa el codificador secuencial\n");
+    
+    if (info->stride > (size_t)INT_MAX) {
+        fprintf(stderr, "❌ Error: Fila demasiado grande para el codificador PNG\n");
+        return 0;
+    }
+    
+    // El codificador recorre las filas de la imagen directamente a través del
+    // stride, sin copia intermedia del cuadro completo.
+    int res = stbi_write_png(rutaSalida, info->ancho, info->alto, info->canales,
+                             info->pixeles, (int)info->stride);
+    
+    if (res) {
+        printf("✓ Imagen guardada exitosamente\n");
+        return 1;
+    } else {
+        fprintf(stderr, "❌ Error: No se pudo guardar el archivo PNG\n");
+        return 0;
+    }
+}
+
+void mostrarMatriz(const ImagenInfo* info) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return;
+    }
+    
+    printf("\n📊 Información de la imagen:\n");
+    printf("   Dimensiones: %dx%d píxeles\n", info->ancho, info->alto);
+    printf("   Canales: %d (%s)\n", info->canales, nombreCanales(info->canales));
+    printf("   Memoria: ~%.2f MB\n", 
+           ((double)info->alto * (double)info->stride) / (1024.0 * 1024.0));
+    
+    printf("\n📋 Primeras filas de la matriz (máximo 8 filas x 12 columnas):\n");
+    int maxFilas = (info->alto < 8) ? info->alto : 8;
+    int maxCols = (info->ancho < 12) ? info->ancho : 12;
+    if (info->canales == 4 && maxCols > 9) maxCols = 9;
+    
+    for (int y = 0; y < maxFilas; y++) {
+        printf("   ");
+        const unsigned char* fila = filaPixeles(info, y);
+        for (int x = 0; x < maxCols; x++) {
+            const unsigned char* p = fila + (size_t)x * info->canales;
+            if (info->canales == 1) {
+                printf("%3u ", p[0]);
+            } else if (info->canales == 2) {
+                printf("(%3u,%3u) ", p[0], p[1]);
+            } else if (info->canales == 3) {
+                printf("(%3u,%3u,%3u) ", p[0], p[1], p[2]);
+            } else {
+                printf("(%3u,%3u,%3u,%3u) ", p[0], p[1], p[2], p[3]);
+            }
+        }
+        printf("\n");
+    }
+    
+    if (info->alto > maxFilas) {
+        printf("   ... (%d filas más)\n", info->alto - maxFilas);
+    }
+}
+
+// ============================================================================
+// BRILLO CONCURRENTE
+// ============================================================================
+
+typedef struct {
+    unsigned char* pixeles;
+    size_t stride;
+    int ancho, canales;
+    int delta;
+    unsigned char lut[256];  // valor de salida para cada valor de entrada
+} BrilloArgs;
+
+// El brillo es una función byte a byte: las filas contiguas se procesan con
+// suma/resta saturada SIMD (paddusb/psubusb) y los bytes sobrantes al final
+// de cada fila con la tabla de 256 entradas. El patrón de desplazamientos
+// tiene 0 en las posiciones de alfa; como 16 y 32 son múltiplos de 2 y 4,
+// el patrón queda alineado con los píxeles en cada bloque.
+void ajustarBrilloHilo(void* arg, int inicio, int fin, int hiloId) {
+    BrilloArgs* a = (BrilloArgs*)arg;
+    (void)hiloId;
+    
+    int bytesFila = a->ancho * a->canales;
+    int color = canalesColor(a->canales);
+    
+#if defined(__AVX2__) || defined(__SSE2__)
+    unsigned char patron[32];
+    int magnitud = (a->delta >= 0) ? a->delta : -a->delta;
+    if (magnitud > 255) magnitud = 255;
+    for (int j = 0; j < 32; j++) {
+        patron[j] = (j % a->canales < color) ? (unsigned char)magnitud : 0;
+    }
+#endif
+#if defined(__AVX2__)
+    __m256i vDelta = _mm256_loadu_si256((const __m256i*)patron);
+#elif defined(__SSE2__)
+    __m128i vDelta = _mm_loadu_si128((const __m128i*)patron);
+#endif
+    
+    for (int y = inicio; y < fin; y++) {
+        unsigned char* fila = a->pixeles + (size_t)y * a->stride;
+        int i = 0;
+        
+#if defined(__AVX2__)
+        if (a->delta >= 0) {
+            for (; i + 32 <= bytesFila; i += 32) {
+                __m256i v = _mm256_loadu_si256((const __m256i*)(fila + i));
+                _mm256_storeu_si256((__m256i*)(fila + i), _mm256_adds_epu8(v, vDelta));
+            }
+        } else {
+            for (; i + 32 <= bytesFila; i += 32) {
+                __m256i v = _mm256_loadu_si256((const __m256i*)(fila + i));
+                _mm256_storeu_si256((__m256i*)(fila + i), _mm256_subs_epu8(v, vDelta));
+            }
+        }
+#elif defined(__SSE2__)
+        if (a->delta >= 0) {
+            for (; i + 16 <= bytesFila; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(fila + i));
+                _mm_storeu_si128((__m128i*)(fila + i), _mm_adds_epu8(v, vDelta));
+            }
+        } else {
+            for (; i + 16 <= bytesFila; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(fila + i));
+                _mm_storeu_si128((__m128i*)(fila + i), _mm_subs_epu8(v, vDelta));
+            }
+        }
+#endif
+        
+        if (color == a->canales) {
+            for (; i < bytesFila; i++) {
+                fila[i] = a->lut[fila[i]];
+            }
+        } else {
+            for (; i < bytesFila; i++) {
+                if (i % a->canales < color) fila[i] = a->lut[fila[i]];
+            }
+        }
+    }
+}
+
+int ajustarBrilloConcurrente(ImagenInfo* info, int delta, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    if (numHilos > info->alto) numHilos = info->alto;
+    
+    printf("🔧 Ajustando brillo %s%d con %d hilos...\n", 
+           delta >= 0 ? "+" : "", delta, numHilos);
+    
+    BrilloArgs args;
+    args.pixeles = info->pixeles;
+    args.stride = info->stride;
+    args.ancho = info->ancho;
+    args.canales = info->canales;
+    args.delta = delta;
+    for (int v = 0; v < 256; v++) {
+        args.lut[v] = clampuc(v + delta);
+    }
+    
+    int hilosUsados = paraleloFilas(info->alto, numHilos, ajustarBrilloHilo, &args);
+    
+    printf("✓ Brillo ajustado correctamente (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+// ============================================================================
+// OPERACIONES PUNTUALES (CADENAS DE TABLAS LUT)
+// ============================================================================
+
+#define CANAL_TODOS -1
+
+// Una cadena de operaciones puntuales se guarda ya compuesta: lut[c][v] es
+// el resultado de aplicar todas las operaciones, en orden, al valor v del
+// canal c. Añadir una operación cuesta 256 consultas por canal y aplicar la
+// cadena completa es una sola pasada sobre la imagen. El canal alfa nunca
+// se modifica.
+typedef struct {
+    unsigned char lut[4][256];
+    int numOperaciones;
+    char descripcion[256];
+} CadenaLUT;
+
+void iniciarCadenaLUT(CadenaLUT* cadena) {
+    for (int c = 0; c < 4; c++) {
+        for (int v = 0; v < 256; v++) cadena->lut[c][v] = (unsigned char)v;
+    }
+    cadena->numOperaciones = 0;
+    cadena->descripcion[0] = '\0';
+}
+
+// Compone f detrás de la cadena actual en el canal indicado (o en todos).
+static void componerLUT(CadenaLUT* cadena, int canal, const unsigned char f[256], const char* nombre) {
+    for (int c = 0; c < 4; c++) {
+        if (canal != CANAL_TODOS && canal != c) continue;
+        for (int v = 0; v < 256; v++) {
+            cadena->lut[c][v] = f[cadena->lut[c][v]];
+        }
+    }
+    
+    size_t usado = strlen(cadena->descripcion);
+    snprintf(cadena->descripcion + usado, sizeof(cadena->descripcion) - usado, "%s%s",
+             cadena->numOperaciones > 0 ? " → " : "", nombre);
+    cadena->numOperaciones++;
+}
+
+void cadenaBrillo(CadenaLUT* cadena, int delta) {
+    unsigned char f[256];
+    char nombre[32];
+    for (int v = 0; v < 256; v++) f[v] = clampuc(v + delta);
+    snprintf(nombre, sizeof(nombre), "brillo %+d", delta);
+    componerLUT(cadena, CANAL_TODOS, f, nombre);
+}
+
+// factor > 1 aumenta el contraste alrededor del gris medio; < 1 lo reduce.
+void cadenaContraste(CadenaLUT* cadena, float factor) {
+    unsigned char f[256];
+    char nombre[32];
+    for (int v = 0; v < 256; v++) {
+        f[v] = clampuc((int)roundf(((float)v - 127.5f) * factor + 127.5f));
+    }
+    snprintf(nombre, sizeof(nombre), "contraste x%.2f", factor);
+    componerLUT(cadena, CANAL_TODOS, f, nombre);
+}
+
+// gamma > 1 aclara los tonos medios; < 1 los oscurece.
+void cadenaGamma(CadenaLUT* cadena, float gamma) {
+    unsigned char f[256];
+    char nombre[32];
+    for (int v = 0; v < 256; v++) {
+        f[v] = clampuc((int)roundf(255.0f * powf((float)v / 255.0f, 1.0f / gamma)));
+    }
+    snprintf(nombre, sizeof(nombre), "gamma %.2f", gamma);
+    componerLUT(cadena, CANAL_TODOS, f, nombre);
+}
+
+void cadenaInvertir(CadenaLUT* cadena) {
+    unsigned char f[256];
+    for (int v = 0; v < 256; v++) f[v] = (unsigned char)(255 - v);
+    componerLUT(cadena, CANAL_TODOS, f, "invertir");
+}
+
+// Binariza cada canal de color por separado.
+void cadenaUmbral(CadenaLUT* cadena, int umbral) {
+    unsigned char f[256];
+    char nombre[32];
+    for (int v = 0; v < 256; v++) f[v] = (v >= umbral) ? 255 : 0;
+    snprintf(nombre, sizeof(nombre), "umbral %d", umbral);
+    componerLUT(cadena, CANAL_TODOS, f, nombre);
+}
+
+// Niveles: lleva [negroEntrada, blancoEntrada] a [0, 1], aplica gamma y
+// reescala a [negroSalida, blancoSalida].
+void cadenaNiveles(CadenaLUT* cadena, int negroEntrada, int blancoEntrada, float gamma,
+                   int negroSalida, int blancoSalida) {
+    unsigned char f[256];
+    char nombre[48];
+    float rango = (float)(blancoEntrada - negroEntrada);
+    if (rango < 1.0f) rango = 1.0f;
+    
+    for (int v = 0; v < 256; v++) {
+        float t = ((float)v - (float)negroEntrada) / rango;
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+        t = powf(t, 1.0f / gamma);
+        f[v] = clampuc((int)roundf((float)negroSalida + t * (float)(blancoSalida - negroSalida)));
+    }
+    snprintf(nombre, sizeof(nombre), "niveles %d-%d γ%.2f → %d-%d",
+             negroEntrada, blancoEntrada, gamma, negroSalida, blancoSalida);
+    componerLUT(cadena, CANAL_TODOS, f, nombre);
+}
+
+// Curva lineal a tramos definida por n puntos de control (entrada
+// estrictamente creciente). Fuera de los extremos la curva es constante.
+void cadenaCurva(CadenaLUT* cadena, int canal, const int* entrada, const int* salida, int n) {
+    unsigned char f[256];
+    char nombre[32];
+    
+    for (int v = 0; v < 256; v++) {
+        if (v <= entrada[0]) {
+            f[v] = clampuc(salida[0]);
+        } else if (v >= entrada[n - 1]) {
+            f[v] = clampuc(salida[n - 1]);
+        } else {
+            int k = 1;
+            while (entrada[k] < v) k++;
+            float t = (float)(v - entrada[k - 1]) / (float)(entrada[k] - entrada[k - 1]);
+            f[v] = clampuc((int)roundf((float)salida[k - 1] + t * (float)(salida[k] - salida[k - 1])));
+        }
+    }
+    
+    if (canal == CANAL_TODOS) {
+        snprintf(nombre, sizeof(nombre), "curva (%d puntos)", n);
+    } else {
+        snprintf(nombre, sizeof(nombre), "curva canal %d (%d puntos)", canal, n);
+    }
+    componerLUT(cadena, canal, f, nombre);
+}
+
+typedef struct {
+    unsigned char* pixeles;
+    size_t stride;
+    int ancho, canales;
+    const CadenaLUT* cadena;
+} CadenaArgs;
+
+void aplicarCadenaHilo(void* arg, int inicio, int fin, int hiloId) {
+    CadenaArgs* a = (CadenaArgs*)arg;
+    const unsigned char* l0 = a->cadena->lut[0];
+    const unsigned char* l1 = a->cadena->lut[1];
+    const unsigned char* l2 = a->cadena->lut[2];
+    (void)hiloId;
+    
+    for (int y = inicio; y < fin; y++) {
+        unsigned char* p = a->pixeles + (size_t)y * a->stride;
+        unsigned char* finFila = p + (size_t)a->ancho * a->canales;
+        
+        switch (a->canales) {
+            case 1:
+                for (; p < finFila; p++) p[0] = l0[p[0]];
+                break;
+            case 2:
+                for (; p < finFila; p += 2) p[0] = l0[p[0]];
+                break;
+            case 3:
+                for (; p < finFila; p += 3) {
+                    p[0] = l0[p[0]];
+                    p[1] = l1[p[1]];
+                    p[2] = l2[p[2]];
+                }
+                break;
+            default:
+                for (; p < finFila; p += 4) {
+                    p[0] = l0[p[0]];
+                    p[1] = l1[p[1]];
+                    p[2] = l2[p[2]];
+                }
+                break;
+        }
+    }
+}
+
+int aplicarCadenaLUTConcurrente(ImagenInfo* info, const CadenaLUT* cadena, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    if (cadena->numOperaciones == 0) {
+        printf("⚠ La cadena está vacía. No se realizarán cambios.\n");
+        return 1;
+    }
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    if (numHilos > info->alto) numHilos = info->alto;
+    
+    printf("🔧 Aplicando %d operación(es) puntual(es) en una pasada con %d hilos...\n",
+           cadena->numOperaciones, numHilos);
+    printf("   Cadena: %s\n", cadena->descripcion);
+    
+    CadenaArgs args;
+    args.pixeles = info->pixeles;
+    args.stride = info->stride;
+    args.ancho = info->ancho;
+    args.canales = info->canales;
+    args.cadena = cadena;
+    
+    int hilosUsados = paraleloFilas(info->alto, numHilos, aplicarCadenaHilo, &args);
+    printf("✓ Ajustes de tono aplicados correctamente (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+// ============================================================================
+// CONVOLUCIÓN GAUSSIANA
+// ============================================================================
+
+#define CONV_LADO_TESELA_2D 64           // píxeles de salida por lado en el recorrido 2D
+#define CONV_BYTES_TESELA (256 * 1024)   // buffer float por tesela separable (cabe en L2)
+#define CONV_FILAS_TESELA_MIN 64         // filas de salida mínimas por tesela separable
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int ancho, alto, canales, tamKernel;
+    const float* kernel;
+    int teselasX;                // teselas de CONV_LADO_TESELA_2D por fila
+    atomic_int errores;
+} ConvArgs;
+
+// Cada tarea es una tesela de salida de CONV_LADO_TESELA_2D píxeles de lado.
+// Su vecindario (la tesela más un halo de k/2 píxeles, con réplica de bordes)
+// se copia a un bloque contiguo, así los k² accesos por muestra caen en un
+// bloque que cabe en L1/L2 en vez de en k filas completas de la imagen.
+void aplicarConvolucionHilo(void* arg, int inicio, int fin, int hiloId) {
+    ConvArgs* a = (ConvArgs*)arg;
+    int k2 = a->tamKernel / 2;
+    int ch = a->canales;
+    int lado = CONV_LADO_TESELA_2D + 2 * k2;
+    (void)hiloId;
+    
+    unsigned char* bloque = malloc((size_t)lado * lado * ch);
+    if (!bloque) {
+        atomic_fetch_add(&a->errores, 1);
+        return;
+    }
+    
+    for (int t = inicio; t < fin; t++) {
+        int x0 = (t % a->teselasX) * CONV_LADO_TESELA_2D;
+        int y0 = (t / a->teselasX) * CONV_LADO_TESELA_2D;
+        int x1 = (x0 + CONV_LADO_TESELA_2D < a->ancho) ? x0 + CONV_LADO_TESELA_2D : a->ancho;
+        int y1 = (y0 + CONV_LADO_TESELA_2D < a->alto) ? y0 + CONV_LADO_TESELA_2D : a->alto;
+        int anchoBloque = x1 - x0 + 2 * k2;
+        size_t strideBloque = (size_t)anchoBloque * ch;
+        
+        for (int r = 0; r < y1 - y0 + 2 * k2; r++) {
+            int yy = y0 - k2 + r;
+            if (yy < 0) yy = 0;
+            if (yy >= a->alto) yy = a->alto - 1;
+            
+            const unsigned char* filaSrc = a->src + (size_t)yy * a->strideSrc;
+            unsigned char* filaBloque = bloque + (size_t)r * strideBloque;
+            for (int i = 0; i < anchoBloque; i++) {
+                int xx = x0 - k2 + i;
+                if (xx < 0) xx = 0;
+                if (xx >= a->ancho) xx = a->ancho - 1;
+                memcpy(filaBloque + (size_t)i * ch, filaSrc + (size_t)xx * ch, ch);
+            }
+        }
+        
+        for (int y = y0; y < y1; y++) {
+            unsigned char* filaDst = a->dst + (size_t)y * a->strideDst;
+            
+            for (int x = x0; x < x1; x++) {
+                for (int c = 0; c < ch; c++) {
+                    float acc = 0.0f;
+                    
+                    for (int ky = 0; ky < a->tamKernel; ky++) {
+                        const unsigned char* p = bloque + (size_t)(y - y0 + ky) * strideBloque
+                                               + (size_t)(x - x0) * ch + c;
+                        const float* filaKernel = a->kernel + ky * a->tamKernel;
                         
-                        float kval = a->kernel[(ky + k2) * a->tamKernel + (kx + k2)];
-                        acc += kval * (float)(a->src[yy][xx][c]);
+                        for (int kx = 0; kx < a->tamKernel; kx++) {
+                            acc += filaKernel[kx] * (float)p[(size_t)kx * ch];
+                        }
+                    }
+                    
+                    filaDst[(size_t)x * ch + c] = clampuc((int)roundf(acc));
+                }
+            }
+        }
+    }
+    
+    free(bloque);
+}
+
+float* generarKernelGauss(int tam, float sigma) {
+    if (tam % 2 == 0 || tam < 3) {
+        fprintf(stderr, "❌ Error: Tamaño de kernel inválido (%d)\n", tam);
+        return NULL;
+    }
+    
+    int k2 = tam / 2;
+    float* kernel = malloc((size_t)tam * tam * sizeof(float));
+    if (!kernel) {
+        fprintf(stderr, "❌ Error: No se pudo asignar memoria para kernel\n");
+        return NULL;
+    }
+    
+    float sum = 0.0f;
+    float denom = 2.0f * sigma * sigma;
+    
+    for (int y = -k2; y <= k2; y++) {
+        for (int x = -k2; x <= k2; x++) {
+            float val = expf(-((float)(x * x + y * y)) / denom) / (M_PI * denom);
+            kernel[(y + k2) * tam + (x + k2)] = val;
+            sum += val;
+        }
+    }
+    
+    if (sum > 0.0f) {
+        for (int i = 0; i < tam * tam; i++) {
+            kernel[i] /= sum;
+        }
+    } else {
+        for (int i = 0; i < tam * tam; i++) kernel[i] = 0.0f;
+        kernel[k2 * tam + k2] = 1.0f;
+    }
+    
+    return kernel;
+}
+
+// Un kernel 2D es separable si es el producto exterior de dos kernels 1D
+// (K[i][j] = ky[i] * kx[j]), como ocurre con el Gaussiano. En ese caso la
+// convolución se hace en dos pasadas 1D: O(2k) por muestra en vez de O(k²).
+int descomponerKernelSeparable(const float* kernel, int tam, float* kx, float* ky) {
+    int fPivote = 0, cPivote = 0;
+    float maxAbs = 0.0f;
+    
+    for (int i = 0; i < tam * tam; i++) {
+        if (fabsf(kernel[i]) > maxAbs) {
+            maxAbs = fabsf(kernel[i]);
+            fPivote = i / tam;
+            cPivote = i % tam;
+        }
+    }
+    
+    if (maxAbs == 0.0f) return 0;
+    
+    float pivote = kernel[fPivote * tam + cPivote];
+    for (int j = 0; j < tam; j++) kx[j] = kernel[fPivote * tam + j];
+    for (int i = 0; i < tam; i++) ky[i] = kernel[i * tam + cPivote] / pivote;
+    
+    float tolerancia = 1e-5f * maxAbs;
+    for (int i = 0; i < tam; i++) {
+        for (int j = 0; j < tam; j++) {
+            if (fabsf(kernel[i * tam + j] - ky[i] * kx[j]) > tolerancia) return 0;
+        }
+    }
+    
+    return 1;
+}
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int ancho, alto, canales, tamKernel;
+    const float* kx;
+    const float* ky;
+    int anchoTesela, altoTesela; // píxeles de salida por tesela
+    int teselasX;
+    atomic_int errores;
+} ConvSepArgs;
+
+// s[j] += Σ w[i] * x[j + i * paso] para j en [0, n), sumando los taps en
+// orden como el bucle escalar (mismo redondeo). Con SSE2 cada bloque de 16
+// muestras acumula todos los taps en registros y solo lee x.
+static void sumarPonderado(float* s, const float* x, size_t paso, const float* w, int taps, int n) {
+    int j = 0;
+#if defined(__SSE2__)
+    for (; j + 16 <= n; j += 16) {
+        __m128 s0 = _mm_loadu_ps(s + j), s1 = _mm_loadu_ps(s + j + 4);
+        __m128 s2 = _mm_loadu_ps(s + j + 8), s3 = _mm_loadu_ps(s + j + 12);
+        const float* p = x + j;
+        for (int i = 0; i < taps; i++, p += paso) {
+            __m128 wi = _mm_set1_ps(w[i]);
+            s0 = _mm_add_ps(s0, _mm_mul_ps(wi, _mm_loadu_ps(p)));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(wi, _mm_loadu_ps(p + 4)));
+            s2 = _mm_add_ps(s2, _mm_mul_ps(wi, _mm_loadu_ps(p + 8)));
+            s3 = _mm_add_ps(s3, _mm_mul_ps(wi, _mm_loadu_ps(p + 12)));
+        }
+        _mm_storeu_ps(s + j, s0);
+        _mm_storeu_ps(s + j + 4, s1);
+        _mm_storeu_ps(s + j + 8, s2);
+        _mm_storeu_ps(s + j + 12, s3);
+    }
+#endif
+    for (; j < n; j++) {
+        float acc = s[j];
+        for (int i = 0; i < taps; i++) acc += w[i] * x[j + i * paso];
+        s[j] = acc;
+    }
+}
+
+// Pasada horizontal de una fila restringida a las columnas [x0, x1). El
+// tramo de origen con su halo de k/2 píxeles (réplica del píxel extremo)
+// se pasa a float en 'fuente'; la salida son (x1 - x0) * canales muestras.
+static void convolucionHorizontalTramo(const ConvSepArgs* a, const unsigned char* filaSrc,
+                                       int x0, int x1, float* fuente, float* salida) {
+    int k2 = a->tamKernel / 2;
+    int ch = a->canales;
+    int n = (x1 - x0) * ch;
+    
+    for (int i = 0; i < x1 - x0 + 2 * k2; i++) {
+        int xx = x0 - k2 + i;
+        if (xx < 0) xx = 0;
+        if (xx >= a->ancho) xx = a->ancho - 1;
+        const unsigned char* p = filaSrc + (size_t)xx * ch;
+        for (int c = 0; c < ch; c++) fuente[(size_t)i * ch + c] = (float)p[c];
+    }
+    
+    for (int j = 0; j < n; j++) salida[j] = 0.0f;
+    sumarPonderado(salida, fuente, (size_t)ch, a->kx, a->tamKernel, n);
+}
+
+// Cada tarea es una tesela de salida (tira de columnas x banda de filas).
+// La tesela se recorre de arriba abajo guardando en un anillo las últimas
+// tamKernel filas de la pasada horizontal; cada fila de salida combina las
+// filas del anillo. El anillo se dimensiona para caber en L2, de modo que
+// la pasada vertical no vuelve a memoria como con un buffer intermedio de
+// la imagen entera. Las bandas contiguas recalculan un halo de k - 1 filas.
+void convolucionTeselasHilo(void* arg, int inicio, int fin, int hiloId) {
+    ConvSepArgs* a = (ConvSepArgs*)arg;
+    int k = a->tamKernel;
+    int k2 = k / 2;
+    int ch = a->canales;
+    size_t m = (size_t)a->anchoTesela * ch;
+    (void)hiloId;
+    
+    // Anillo de k filas, acumulador y fuente de la pasada horizontal.
+    float* anillo = malloc(((size_t)(k + 2) * m + (size_t)(k - 1) * ch) * sizeof(float));
+    if (!anillo) {
+        atomic_fetch_add(&a->errores, 1);
+        return;
+    }
+    float* acc = anillo + (size_t)k * m;
+    float* fuente = acc + m;
+    
+    for (int t = inicio; t < fin; t++) {
+        int x0 = (t % a->teselasX) * a->anchoTesela;
+        int y0 = (t / a->teselasX) * a->altoTesela;
+        int x1 = (x0 + a->anchoTesela < a->ancho) ? x0 + a->anchoTesela : a->ancho;
+        int y1 = (y0 + a->altoTesela < a->alto) ? y0 + a->altoTesela : a->alto;
+        int n = (x1 - x0) * ch;
+        
+        // v recorre las filas virtuales [y0 - k2, y1 + k2); la fila v ocupa la
+        // ranura (v - y0 + k2) % k y completa la ventana de la salida v - k2.
+        int ranura = 0;
+        for (int v = y0 - k2; v < y1 + k2; v++) {
+            int yy = v;
+            if (yy < 0) yy = 0;
+            if (yy >= a->alto) yy = a->alto - 1;
+            
+            convolucionHorizontalTramo(a, a->src + (size_t)yy * a->strideSrc, x0, x1,
+                                       fuente, anillo + (size_t)ranura * m);
+            if (++ranura == k) ranura = 0;
+            
+            int y = v - k2;
+            if (y < y0) continue;
+            
+            // Tras escribir v, la ranura siguiente contiene la fila y - k2: los
+            // taps van de esa ranura al final del anillo y luego desde el inicio.
+            for (int j = 0; j < n; j++) acc[j] = 0.0f;
+            sumarPonderado(acc, anillo + (size_t)ranura * m, m, a->ky, k - ranura, n);
+            sumarPonderado(acc, anillo, m, a->ky + (k - ranura), ranura, n);
+            
+            unsigned char* filaDst = a->dst + (size_t)y * a->strideDst + (size_t)x0 * ch;
+            for (int j = 0; j < n; j++) {
+                filaDst[j] = clampuc((int)roundf(acc[j]));
+            }
+        }
+    }
+    
+    free(anillo);
+}
+
+// Convolución con un kernel arbitrario tamKernel x tamKernel, repartida por
+// teselas de salida en lugar de bandas de filas. Los kernels separables
+// usan dos pasadas 1D fusionadas por tesela; el recorrido 2D completo queda
+// para los que no lo son.
+int aplicarKernelConcurrente(ImagenInfo* info, const float* kernel, int tamKernel, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    float* factores = malloc(2 * (size_t)tamKernel * sizeof(float));
+    if (!factores) {
+        fprintf(stderr, "❌ Error: No se pudo asignar memoria para kernel\n");
+        return 0;
+    }
+    
+    int separable = descomponerKernelSeparable(kernel, tamKernel, factores, factores + tamKernel);
+    
+    ImagenInfo dst;
+    if (!crearImagen(&dst, info->ancho, info->alto, info->canales)) {
+        fprintf(stderr, "❌ Error: No se pudo crear matriz destino\n");
+        free(factores);
+        return 0;
+    }
+    
+    int hilosUsados, teselas, errores;
+    
+    if (separable) {
+        ConvSepArgs args;
+        args.src = info->pixeles;
+        args.dst = dst.pixeles;
+        args.strideSrc = info->stride;
+        args.strideDst = dst.stride;
+        args.ancho = info->ancho;
+        args.alto = info->alto;
+        args.canales = info->canales;
+        args.tamKernel = tamKernel;
+        args.kx = factores;
+        args.ky = factores + tamKernel;
+        atomic_init(&args.errores, 0);
+        
+        // Tiras tan anchas como permita el buffer de tesela (anillo de
+        // tamKernel filas, acumulador y fuente) dentro de CONV_BYTES_TESELA,
+        // repartidas a partes iguales; bandas de al menos 4 halos para
+        // acotar el recálculo de filas entre bandas.
+        int anchoMax = (int)(CONV_BYTES_TESELA / ((size_t)(tamKernel + 2) * sizeof(float) * info->canales));
+        if (anchoMax < 16) anchoMax = 16;
+        args.teselasX = (info->ancho + anchoMax - 1) / anchoMax;
+        args.anchoTesela = (info->ancho + args.teselasX - 1) / args.teselasX;
+        args.altoTesela = (4 * (tamKernel - 1) > CONV_FILAS_TESELA_MIN) ? 4 * (tamKernel - 1) : CONV_FILAS_TESELA_MIN;
+        teselas = args.teselasX * ((info->alto + args.altoTesela - 1) / args.altoTesela);
+        
+        hilosUsados = paraleloFilas(teselas, numHilos, convolucionTeselasHilo, &args);
+        errores = atomic_load(&args.errores);
+    } else {
+        ConvArgs args;
+        args.src = info->pixeles;
+        args.dst = dst.pixeles;
+        args.strideSrc = info->stride;
+        args.strideDst = dst.stride;
+        args.ancho = info->ancho;
+        args.alto = info->alto;
+        args.canales = info->canales;
+        args.tamKernel = tamKernel;
+        args.kernel = kernel;
+        args.teselasX = (info->ancho + CONV_LADO_TESELA_2D - 1) / CONV_LADO_TESELA_2D;
+        atomic_init(&args.errores, 0);
+        teselas = args.teselasX * ((info->alto + CONV_LADO_TESELA_2D - 1) / CONV_LADO_TESELA_2D);
+        
+        hilosUsados = paraleloFilas(teselas, numHilos, aplicarConvolucionHilo, &args);
+        errores = atomic_load(&args.errores);
+    }
+    
+    free(factores);
+    
+    if (errores > 0) {
+        fprintf(stderr, "❌ Error: Memoria insuficiente para los buffers de tesela (%d tareas fallidas)\n", errores);
+        liberarImagen(&dst);
+        return 0;
+    }
+    
+    liberarImagen(info);
+    *info = dst;
+    
+    printf("✓ Convolución aplicada correctamente (%s, %d teselas, %d hilos utilizados)\n",
+           separable ? "separable en dos pasadas 1D" : "kernel 2D", teselas, hilosUsados);
+    return 1;
+}
+
+int aplicarConvolucionConcurrente(ImagenInfo* info, int tamKernel, float sigma, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    if (tamKernel % 2 == 0 || tamKernel < 3) {
+        printf("❌ Error: El tamaño del kernel debe ser impar y >= 3\n");
+        return 0;
+    }
+    
+    if (sigma <= 0.0f) {
+        printf("⚠ Sigma inválido, usando 1.0\n");
+        sigma = 1.0f;
+    }
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    if (numHilos > info->alto) numHilos = info->alto;
+    
+    printf("🔧 Aplicando convolución Gaussiana (kernel %dx%d, σ=%.2f) con %d hilos...\n", 
+           tamKernel, tamKernel, sigma, numHilos);
+    
+    float* kernel = generarKernelGauss(tamKernel, sigma);
+    if (!kernel) return 0;
+    
+    int ok = aplicarKernelConcurrente(info, kernel, tamKernel, numHilos);
+    free(kernel);
+    return ok;
+}
+
+// ============================================================================
+// DESENFOQUE RÁPIDO (TRES CAJAS)
+// ============================================================================
+
+#define TIRA_COLUMNAS 256  // bytes de fila por tarea en la pasada vertical
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int ancho, alto, canales, radio;
+} CajaArgs;
+
+// Tamaños de tres cajas sucesivas cuya composición aproxima un Gaussiano
+// de la sigma dada (la varianza de una caja de ancho w es (w² - 1) / 12).
+void calcularCajasGauss(float sigma, int n, int* radios) {
+    float wIdeal = sqrtf(12.0f * sigma * sigma / n + 1.0f);
+    int wl = (int)floorf(wIdeal);
+    if (wl % 2 == 0) wl--;
+    if (wl < 1) wl = 1;
+    int wu = wl + 2;
+    
+    float mIdeal = (12.0f * sigma * sigma - n * wl * wl - 4.0f * n * wl - 3.0f * n) / (-4.0f * wl - 4.0f);
+    int m = (int)roundf(mIdeal);
+    
+    for (int i = 0; i < n; i++) {
+        radios[i] = ((i < m ? wl : wu) - 1) / 2;
+    }
+}
+
+// Media móvil por filas: cada salida suma la entrada que llega y resta la
+// que sale, así el coste por píxel no depende del radio.
+void cajaHorizontalHilo(void* arg, int inicio, int fin, int hiloId) {
+    CajaArgs* a = (CajaArgs*)arg;
+    int r = a->radio, ch = a->canales, n = a->ancho;
+    float inv = 1.0f / (float)(2 * r + 1);
+    (void)hiloId;
+    
+    for (int y = inicio; y < fin; y++) {
+        const unsigned char* filaSrc = a->src + (size_t)y * a->strideSrc;
+        unsigned char* filaDst = a->dst + (size_t)y * a->strideDst;
+        
+        for (int c = 0; c < ch; c++) {
+            const unsigned char* v = filaSrc + c;
+            int suma = (r + 1) * v[0];
+            for (int i = 1; i <= r; i++) {
+                suma += v[(size_t)(i < n ? i : n - 1) * ch];
+            }
+            
+            for (int x = 0; x < n; x++) {
+                filaDst[(size_t)x * ch + c] = (unsigned char)((float)suma * inv + 0.5f);
+                int entra = x + r + 1;
+                int sale = x - r;
+                if (entra > n - 1) entra = n - 1;
+                if (sale < 0) sale = 0;
+                suma += v[(size_t)entra * ch] - v[(size_t)sale * ch];
+            }
+        }
+    }
+}
+
+// Media móvil por columnas. Cada tarea recorre una tira de TIRA_COLUMNAS
+// bytes de ancho de arriba abajo con un acumulador por columna, de modo
+// que los accesos siguen siendo segmentos contiguos de fila.
+void cajaVerticalHilo(void* arg, int inicio, int fin, int hiloId) {
+    CajaArgs* a = (CajaArgs*)arg;
+    int r = a->radio, h = a->alto;
+    int n = a->ancho * a->canales;
+    float inv = 1.0f / (float)(2 * r + 1);
+    int suma[TIRA_COLUMNAS];
+    (void)hiloId;
+    
+    for (int tira = inicio; tira < fin; tira++) {
+        int j0 = tira * TIRA_COLUMNAS;
+        int m = (n - j0 < TIRA_COLUMNAS) ? n - j0 : TIRA_COLUMNAS;
+        
+        const unsigned char* primera = a->src + j0;
+        for (int j = 0; j < m; j++) suma[j] = (r + 1) * primera[j];
+        for (int i = 1; i <= r; i++) {
+            const unsigned char* fila = a->src + (size_t)(i < h ? i : h - 1) * a->strideSrc + j0;
+            for (int j = 0; j < m; j++) suma[j] += fila[j];
+        }
+        
+        for (int y = 0; y < h; y++) {
+            unsigned char* filaDst = a->dst + (size_t)y * a->strideDst + j0;
+            for (int j = 0; j < m; j++) {
+                filaDst[j] = (unsigned char)((float)suma[j] * inv + 0.5f);
+            }
+            
+            int entra = y + r + 1;
+            int sale = y - r;
+            if (entra > h - 1) entra = h - 1;
+            if (sale < 0) sale = 0;
+            const unsigned char* filaEntra = a->src + (size_t)entra * a->strideSrc + j0;
+            const unsigned char* filaSale = a->src + (size_t)sale * a->strideSrc + j0;
+            for (int j = 0; j < m; j++) {
+                suma[j] += filaEntra[j] - filaSale[j];
+            }
+        }
+    }
+}
+
+// Desenfoque aproximadamente Gaussiano con coste constante por píxel:
+// tres pasadas de caja horizontales y verticales con sumas móviles.
+int aplicarDesenfoqueRapidoConcurrente(ImagenInfo* info, float sigma, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    if (sigma <= 0.0f) {
+        printf("⚠ Sigma inválido, usando 1.0\n");
+        sigma = 1.0f;
+    }
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    
+    int radios[3];
+    calcularCajasGauss(sigma, 3, radios);
+    
+    printf("🔧 Aplicando desenfoque rápido (σ=%.2f, cajas de radio %d/%d/%d) con %d hilos...\n",
+           sigma, radios[0], radios[1], radios[2], numHilos);
+    
+    ImagenInfo dst, tmp;
+    if (!crearImagen(&dst, info->ancho, info->alto, info->canales)) {
+        fprintf(stderr, "❌ Error: No se pudo crear matriz destino\n");
+        return 0;
+    }
+    if (!crearImagen(&tmp, info->ancho, info->alto, info->canales)) {
+        fprintf(stderr, "❌ Error: No se pudo crear matriz intermedia\n");
+        liberarImagen(&dst);
+        return 0;
+    }
+    
+    int tiras = (info->ancho * info->canales + TIRA_COLUMNAS - 1) / TIRA_COLUMNAS;
+    int hilosUsados = 0;
+    const ImagenInfo* origen = info;
+    
+    for (int i = 0; i < 3; i++) {
+        CajaArgs h = { origen->pixeles, tmp.pixeles, origen->stride, tmp.stride,
+                       info->ancho, info->alto, info->canales, radios[i] };
+        int usados = paraleloFilas(info->alto, numHilos, cajaHorizontalHilo, &h);
+        if (usados > hilosUsados) hilosUsados = usados;
+        
+        CajaArgs v = { tmp.pixeles, dst.pixeles, tmp.stride, dst.stride,
+                       info->ancho, info->alto, info->canales, radios[i] };
+        usados = paraleloFilas(tiras, numHilos, cajaVerticalHilo, &v);
+        if (usados > hilosUsados) hilosUsados = usados;
+        
+        origen = &dst;
+    }
+    
+    liberarImagen(&tmp);
+    liberarImagen(info);
+    *info = dst;
+    
+    printf("✓ Desenfoque rápido aplicado correctamente (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+// ============================================================================
+// ROTACIÓN EXACTA (MÚLTIPLOS DE 90°) Y VOLTEO
+// ============================================================================
+
+#define TAM_TESELA 64  // lado (en píxeles) de las teselas de la transposición
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int anchoSrc, altoSrc, anchoDst, altoDst, canales;
+    int vueltas;  // 1 = 90°, 2 = 180°, 3 = 270°
+    int teselasX; // teselas por fila del destino
+} Rot90Args;
+
+// Copia una tesela del destino [x0, x1) x [y0, y1). Con la misma geometría
+// que rotarImagenConcurrente para ángulos positivos:
+//   90°:  dst(x, y) = src(y, h - 1 - x)
+//   180°: dst(x, y) = src(w - 1 - x, h - 1 - y)
+//   270°: dst(x, y) = src(w - 1 - y, x)
+// ch es constante en cada llamada desde copiarTeselaRotada, así el
+// compilador genera una copia de píxel especializada para 1-4 canales.
+static inline void rotarTesela(const Rot90Args* a, int x0, int x1, int y0, int y1, const int ch) {
+    for (int y = y0; y < y1; y++) {
+        unsigned char* d = a->dst + (size_t)y * a->strideDst + (size_t)x0 * ch;
+        for (int x = x0; x < x1; x++, d += ch) {
+            int sx, sy;
+            if (a->vueltas == 1) {
+                sx = y;
+                sy = a->altoSrc - 1 - x;
+            } else if (a->vueltas == 2) {
+                sx = a->anchoSrc - 1 - x;
+                sy = a->altoSrc - 1 - y;
+            } else {
+                sx = a->anchoSrc - 1 - y;
+                sy = x;
+            }
+            const unsigned char* p = a->src + (size_t)sy * a->strideSrc + (size_t)sx * ch;
+            for (int c = 0; c < ch; c++) d[c] = p[c];
+        }
+    }
+}
+
+static void copiarTeselaRotada(const Rot90Args* a, int x0, int x1, int y0, int y1) {
+    switch (a->canales) {
+        case 1: rotarTesela(a, x0, x1, y0, y1, 1); break;
+        case 2: rotarTesela(a, x0, x1, y0, y1, 2); break;
+        case 3: rotarTesela(a, x0, x1, y0, y1, 3); break;
+        default: rotarTesela(a, x0, x1, y0, y1, 4); break;
+    }
+}
+
+// Cada tarea es una tesela del destino (índice = fila * teselasX + columna),
+// así hasta una imagen de pocas filas de teselas se reparte entre los hilos.
+// Las lecturas de origen de una tesela (columnas de 64 píxeles en 90°/270°)
+// quedan dentro de 64 filas que caben en caché.
+void rotar90Hilo(void* arg, int inicio, int fin, int hiloId) {
+    Rot90Args* a = (Rot90Args*)arg;
+    (void)hiloId;
+    
+    for (int t = inicio; t < fin; t++) {
+        int y0 = (t / a->teselasX) * TAM_TESELA;
+        int x0 = (t % a->teselasX) * TAM_TESELA;
+        int y1 = (y0 + TAM_TESELA < a->altoDst) ? y0 + TAM_TESELA : a->altoDst;
+        int x1 = (x0 + TAM_TESELA < a->anchoDst) ? x0 + TAM_TESELA : a->anchoDst;
+        copiarTeselaRotada(a, x0, x1, y0, y1);
+    }
+}
+
+// Rotación sin pérdidas en múltiplos de 90° (vueltas de 90° en el sentido
+// de los ángulos positivos de rotarImagenConcurrente).
+int rotar90Concurrente(ImagenInfo* info, int vueltas, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    vueltas = ((vueltas % 4) + 4) % 4;
+    if (vueltas == 0) {
+        printf("✓ Rotación de 0° (múltiplo de 360°): la imagen no cambia\n");
+        return 1;
+    }
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    
+    int anchoDst = (vueltas == 2) ? info->ancho : info->alto;
+    int altoDst = (vueltas == 2) ? info->alto : info->ancho;
+    
+    printf("🔧 Rotando imagen %d° (exacta, por teselas) con %d hilos...\n", vueltas * 90, numHilos);
+    printf("   Nueva dimensión: %dx%d píxeles\n", anchoDst, altoDst);
+    
+    ImagenInfo dst;
+    if (!crearImagen(&dst, anchoDst, altoDst, info->canales)) {
+        fprintf(stderr, "❌ Error: No se pudo crear matriz destino para rotación\n");
+        return 0;
+    }
+    
+    Rot90Args args;
+    args.src = info->pixeles;
+    args.dst = dst.pixeles;
+    args.strideSrc = info->stride;
+    args.strideDst = dst.stride;
+    args.anchoSrc = info->ancho;
+    args.altoSrc = info->alto;
+    args.anchoDst = anchoDst;
+    args.altoDst = altoDst;
+    args.canales = info->canales;
+    args.vueltas = vueltas;
+    args.teselasX = (anchoDst + TAM_TESELA - 1) / TAM_TESELA;
+    
+    int filasTeselas = (altoDst + TAM_TESELA - 1) / TAM_TESELA;
+    int hilosUsados = paraleloFilas(args.teselasX * filasTeselas, numHilos, rotar90Hilo, &args);
+    
+    liberarImagen(info);
+    *info = dst;
+    
+    printf("✓ Rotación completada (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+typedef struct {
+    unsigned char* pixeles;
+    size_t stride;
+    int ancho, alto, canales;
+    int horizontal, vertical;
+} VolteoArgs;
+
+static void invertirFila(unsigned char* fila, int ancho, int ch) {
+    unsigned char* i = fila;
+    unsigned char* j = fila + (size_t)(ancho - 1) * ch;
+    for (; i < j; i += ch, j -= ch) {
+        for (int c = 0; c < ch; c++) {
+            unsigned char t = i[c];
+            i[c] = j[c];
+            j[c] = t;
+        }
+    }
+}
+
+static void intercambiarFilas(unsigned char* a, unsigned char* b, size_t n) {
+    unsigned char tmp[1024];
+    while (n > 0) {
+        size_t k = (n < sizeof(tmp)) ? n : sizeof(tmp);
+        memcpy(tmp, a, k);
+        memcpy(a, b, k);
+        memcpy(b, tmp, k);
+        a += k;
+        b += k;
+        n -= k;
+    }
+}
+
+// Volteo en el sitio. Cada tarea procesa la fila y de la mitad superior
+// junto con su espejo alto - 1 - y, así ningún par lo tocan dos hilos.
+void voltearHilo(void* arg, int inicio, int fin, int hiloId) {
+    VolteoArgs* a = (VolteoArgs*)arg;
+    size_t bytesFila = (size_t)a->ancho * a->canales;
+    (void)hiloId;
+    
+    for (int y = inicio; y < fin; y++) {
+        unsigned char* f1 = a->pixeles + (size_t)y * a->stride;
+        
+        if (!a->vertical) {
+            invertirFila(f1, a->ancho, a->canales);
+            continue;
+        }
+        
+        int yEspejo = a->alto - 1 - y;
+        unsigned char* f2 = a->pixeles + (size_t)yEspejo * a->stride;
+        if (yEspejo != y) intercambiarFilas(f1, f2, bytesFila);
+        if (a->horizontal) {
+            invertirFila(f1, a->ancho, a->canales);
+            if (yEspejo != y) invertirFila(f2, a->ancho, a->canales);
+        }
+    }
+}
+
+// Volteo horizontal (espejo izquierda-derecha) y/o vertical (arriba-abajo),
+// sin pérdidas y en el sitio. Ambos a la vez equivalen a rotar 180°.
+int voltearImagenConcurrente(ImagenInfo* info, int horizontal, int vertical, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    if (!horizontal && !vertical) return 1;
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    
+    printf("🔧 Volteando imagen (%s) con %d hilos...\n",
+           horizontal && vertical ? "horizontal y vertical" : horizontal ? "horizontal" : "vertical",
+           numHilos);
+    
+    VolteoArgs args;
+    args.pixeles = info->pixeles;
+    args.stride = info->stride;
+    args.ancho = info->ancho;
+    args.alto = info->alto;
+    args.canales = info->canales;
+    args.horizontal = horizontal;
+    args.vertical = vertical;
+    
+    int filas = vertical ? (info->alto + 1) / 2 : info->alto;
+    int hilosUsados = paraleloFilas(filas, numHilos, voltearHilo, &args);
+    
+    printf("✓ Volteo completado (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+// ============================================================================
+// ROTACIÓN
+// ============================================================================
+
+typedef struct {
+    const unsigned char* pixelesOrigen;
+    unsigned char* pixelesDestino;
+    size_t strideOrigen, strideDestino;
+    int anchoOrigen, altoOrigen, canales;
+    int anchoDestino, altoDestino;
+    float cosA, sinA;
+    float minX, minY;
+    float cx, cy;
+} RotArgs;
+
+#define ROT_BITS_FRAC 32  // bits fraccionarios de las coordenadas de origen
+
+// Recorta [*lo, *hi] a los x del destino cuya coordenada de origen a + b * x
+// cae en [0, limite). Es una estimación en double: rotarWorker la ensancha
+// una columna por lado y la ajusta con la misma aritmética entera del bucle.
+static void intervaloValido(double a, double b, double limite, double* lo, double* hi) {
+    if (b == 0.0) {
+        if (a < 0.0 || a >= limite) {
+            *lo = 1.0;
+            *hi = 0.0;
+        }
+        return;
+    }
+    double t1 = -a / b;
+    double t2 = (limite - a) / b;
+    if (t1 > t2) {
+        double t = t1;
+        t1 = t2;
+        t2 = t;
+    }
+    if (t1 > *lo) *lo = t1;
+    if (t2 < *hi) *hi = t2;
+}
+
+// Bilineal con pesos enteros de 8 bits sobre coordenadas en punto fijo.
+// ch es constante en cada llamada desde rotarWorker.
+static inline void rotarTramo(const RotArgs* r, unsigned char* d, int n,
+                              int64_t fx, int64_t fy, int64_t dx, int64_t dy, const int ch) {
+    const int ultimoX = r->anchoOrigen - 1, ultimoY = r->altoOrigen - 1;
+    
+    for (int i = 0; i < n; i++, d += ch, fx += dx, fy += dy) {
+        int x0 = (int)(fx >> ROT_BITS_FRAC);
+        int y0 = (int)(fy >> ROT_BITS_FRAC);
+        int wx = (int)((fx >> (ROT_BITS_FRAC - 8)) & 0xFF);
+        int wy = (int)((fy >> (ROT_BITS_FRAC - 8)) & 0xFF);
+        int ox = (x0 < ultimoX) ? ch : 0;
+        size_t oy = (y0 < ultimoY) ? r->strideOrigen : 0;
+        
+        const unsigned char* p0 = r->pixelesOrigen + (size_t)y0 * r->strideOrigen + (size_t)x0 * ch;
+        const unsigned char* p1 = p0 + oy;
+        
+        for (int c = 0; c < ch; c++) {
+            int arriba = p0[c] * (256 - wx) + p0[ox + c] * wx;
+            int abajo = p1[c] * (256 - wx) + p1[ox + c] * wx;
+            d[c] = (unsigned char)((arriba * (256 - wy) + abajo * wy + 32768) >> 16);
+        }
+    }
+}
+
+// Rotación por filas estilo DDA: a lo largo de una fila del destino la
+// coordenada de origen avanza un paso constante (cosA, -sinA), así que se
+// acumula en punto fijo en vez de recalcularla con cuatro productos por
+// píxel. El tramo de columnas que cae dentro del origen se calcula una vez
+// por fila; el resto es relleno negro con memset.
+void rotarWorker(void* arg, int inicio, int fin, int hiloId) {
+    RotArgs* r = (RotArgs*)arg;
+    const double escala = (double)((int64_t)1 << ROT_BITS_FRAC);
+    const int64_t limX = (int64_t)r->anchoOrigen << ROT_BITS_FRAC;
+    const int64_t limY = (int64_t)r->altoOrigen << ROT_BITS_FRAC;
+    const int64_t dx = llround((double)r->cosA * escala);
+    const int64_t dy = llround(-(double)r->sinA * escala);
+    int ch = r->canales;
+    (void)hiloId;
+    
+    for (int y = inicio; y < fin; y++) {
+        unsigned char* filaDst = r->pixelesDestino + (size_t)y * r->strideDestino;
+        
+        double X0 = (double)r->minX - r->cx;
+        double Y = (double)y + r->minY - r->cy;
+        double sx0 = (double)r->cosA * X0 + (double)r->sinA * Y + r->cx;
+        double sy0 = -(double)r->sinA * X0 + (double)r->cosA * Y + r->cy;
+        int64_t fx0 = llround(sx0 * escala);
+        int64_t fy0 = llround(sy0 * escala);
+        
+        double lo = 0.0, hi = (double)r->anchoDestino;
+        intervaloValido(sx0, r->cosA, r->anchoOrigen, &lo, &hi);
+        intervaloValido(sy0, -r->sinA, r->altoOrigen, &lo, &hi);
+        
+        int xIni = 0, xFin = 0;
+        if (lo <= hi) {
+            xIni = (int)floor(lo) - 1;
+            xFin = (int)ceil(hi) + 1;
+            if (xIni < 0) xIni = 0;
+            if (xFin > r->anchoDestino) xFin = r->anchoDestino;
+        }
+        
+        // Ajuste exacto con la misma aritmética entera del bucle.
+        while (xIni < xFin) {
+            int64_t fx = fx0 + dx * xIni, fy = fy0 + dy * xIni;
+            if (fx >= 0 && fx < limX && fy >= 0 && fy < limY) break;
+            xIni++;
+        }
+        while (xFin > xIni) {
+            int64_t fx = fx0 + dx * (xFin - 1), fy = fy0 + dy * (xFin - 1);
+            if (fx >= 0 && fx < limX && fy >= 0 && fy < limY) break;
+            xFin--;
+        }
+        
+        memset(filaDst, 0, (size_t)xIni * ch);
+        memset(filaDst + (size_t)xFin * ch, 0, (size_t)(r->anchoDestino - xFin) * ch);
+        
+        unsigned char* d = filaDst + (size_t)xIni * ch;
+        int64_t fx = fx0 + dx * xIni, fy = fy0 + dy * xIni;
+        int n = xFin - xIni;
+        switch (ch) {
+            case 1: rotarTramo(r, d, n, fx, fy, dx, dy, 1); break;
+            case 2: rotarTramo(r, d, n, fx, fy, dx, dy, 2); break;
+            case 3: rotarTramo(r, d, n, fx, fy, dx, dy, 3); break;
+            default: rotarTramo(r, d, n, fx, fy, dx, dy, 4); break;
+        }
+    }
+}
+
+int rotarImagenConcurrente(ImagenInfo* info, float anguloGrados, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
+    }
+    
+    // Los múltiplos exactos de 90° no necesitan interpolar: se transponen.
+    if (fmodf(anguloGrados, 90.0f) == 0.0f) {
+        return rotar90Concurrente(info, (int)(anguloGrados / 90.0f), numHilos);
+    }
+    
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    
+    printf("🔧 Rotando imagen %.2f° con %d hilos...\n", anguloGrados, numHilos);
+    
+    float ang = anguloGrados * (float)M_PI / 180.0f;
+    float cosA = cosf(ang), sinA = sinf(ang);
+    int w = info->ancho, h = info->alto;
+    float cx = (w - 1) / 2.0f, cy = (h - 1) / 2.0f;
+    
+    float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
+    float corners[4][2] = {{0, 0}, {(float)(w - 1), 0}, 
+                          {0, (float)(h - 1)}, {(float)(w - 1), (float)(h - 1)}};
+    
+    for (int i = 0; i < 4; i++) {
+        float x = corners[i][0], y = corners[i][1];
+        float rx = cosA * (x - cx) - sinA * (y - cy) + cx;
+        float ry = sinA * (x - cx) + cosA * (y - cy) + cy;
+        if (rx < minX) minX = rx;
+        if (rx > maxX) maxX = rx;
+        if (ry < minY) minY = ry;
+        if (ry > maxY) maxY = ry;
+    }
+    
+    int anchoDestino = (int)floorf(maxX - minX) + 1;
+    int altoDestino = (int)floorf(maxY - minY) + 1;
+    
+    if (anchoDestino <= 0) anchoDestino = 1;
+    if (altoDestino <= 0) altoDestino = 1;
+    
+    printf("   Nueva dimensión: %dx%d píxeles\n", anchoDestino, altoDestino);
+    
+    ImagenInfo dst;
+    if (!crearImagen(&dst, anchoDestino, altoDestino, info->canales)) {
+        fprintf(stderr, "❌ Error: No se pudo crear matriz destino para rotación\n");
+        return 0;
+    }
+    
+    RotArgs args;
+    args.pixelesOrigen = info->pixeles;
+    args.pixelesDestino = dst.pixeles;
+    args.strideOrigen = info->stride;
+    args.strideDestino = dst.stride;
+    args.anchoOrigen = info->ancho;
+    args.altoOrigen = info->alto;
+    args.canales = info->canales;
+    args.anchoDestino = anchoDestino;
+    args.altoDestino = altoDestino;
+    args.cosA = cosA;
+    args.sinA = sinA;
+    args.minX = minX;
+    args.minY = minY;
+    args.cx = cx;
+    args.cy = cy;
+    
+    int hilosUsados = paraleloFilas(altoDestino, numHilos, rotarWorker, &args);
+    
+    liberarImagen(info);
+    *info = dst;
+    
+    printf("✓ Rotación completada (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+// ============================================================================
+// DETECCIÓN DE BORDES SOBEL
+// ============================================================================
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int ancho, alto, canales;
+    atomic_int errores;          // tareas sin memoria para su buffer
+} SobelArgs;
+
+// Implementación directa (luminancia en float recalculada para cada uno de
+// los 9 vecinos). Ya no la usa el menú; se conserva como referencia para
+// el benchmark de Sobel.
+void sobelReferenciaHilo(void* arg, int inicio, int fin, int hiloId) {
+    SobelArgs* s = (SobelArgs*)arg;
+    (void)hiloId;
+    int gx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+    int gy[3][3] = {{1, 2, 1}, {0, 0, 0}, {-1, -2, -1}};
+    
+    for (int y = inicio; y < fin; y++) {
+        for (int x = 0; x < s->ancho; x++) {
+            float sumx = 0.0f, sumy = 0.0f;
+            
+            for (int ky = -1; ky <= 1; ky++) {
+                for (int kx = -1; kx <= 1; kx++) {
+                    int yy = y + ky;
+                    int xx = x + kx;
+                    
+                    if (yy < 0) yy = 0;
+                    if (yy >= s->alto) yy = s->alto - 1;
+                    if (xx < 0) xx = 0;
+                    if (xx >= s->ancho) xx = s->ancho - 1;
+                    
+                    const unsigned char* p = s->src + (size_t)yy * s->strideSrc + (size_t)xx * s->canales;
+                    float valc;
+                    if (s->canales >= 3) {
+                        float r = (float)p[0];
+                        float g = (float)p[1];
+                        float b = (float)p[2];
+                        valc = 0.299f * r + 0.587f * g + 0.114f * b;
+                    } else {
+                        valc = (float)p[0];
                     }
+                    
+                    float gx_val = (float)gx[ky + 1][kx + 1];
+                    float gy_val = (float)gy[ky + 1][kx + 1];
+                    
+                    sumx += gx_val * valc;
+                    sumy += gy_val * valc;
                 }
-                
-                a->dst[y][x][c] = clampuc((int)roundf(acc));
             }
+            
+            float magnitude = sqrtf(sumx * sumx + sumy * sumy);
+            s->dst[(size_t)y * s->strideDst + x] = clampuc((int)roundf(magnitude));
+        }
+    }
+}
+
+#define SOBEL_BITS_LUMA 3  // bits fraccionarios de la luminancia en punto fijo
+
+// Luminancia en punto fijo (x8) de una fila: (77 R + 150 G + 29 B) / 32, que
+// aproxima 8 * (0.299 R + 0.587 G + 0.114 B). luma tiene ancho + 2
+// posiciones: el píxel x va en x + 1 y los extremos replican el borde, así
+// el bucle de Sobel no necesita recortar coordenadas.
+static void filaALuma(const unsigned char* src, int ancho, int canales, int16_t* luma) {
+    if (canales >= 3) {
+        for (int x = 0; x < ancho; x++) {
+            const unsigned char* p = src + (size_t)x * canales;
+            luma[x + 1] = (int16_t)((77 * p[0] + 150 * p[1] + 29 * p[2] + 16) >> (8 - SOBEL_BITS_LUMA));
         }
+    } else {
+        for (int x = 0; x < ancho; x++) {
+            luma[x + 1] = (int16_t)(src[(size_t)x * canales] << SOBEL_BITS_LUMA);
+        }
+    }
+    luma[0] = luma[1];
+    luma[ancho + 1] = luma[ancho];
+}
+
+// Gradientes enteros de una fila a partir de las lumas de las filas
+// anterior (a), actual (c) y siguiente (n). Con luminancia x8, |gx|, |gy| <=
+// 8160: caben en 16 bits y gx² + gy² en 32. La magnitud se redondea igual
+// en la ruta SIMD y en la escalar (floor(m / 8 + 0.5)).
+static void sobelFila(const int16_t* a, const int16_t* c, const int16_t* n, int ancho, unsigned char* dst) {
+    int x = 0;
+    
+#if defined(__SSE2__)
+    const __m128i dos = _mm_set1_epi16(2);
+    const __m128 escala = _mm_set1_ps(1.0f / (1 << SOBEL_BITS_LUMA));
+    const __m128 medio = _mm_set1_ps(0.5f);
+    for (; x + 8 <= ancho; x += 8) {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(a + x));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(a + x + 1));
+        __m128i a2 = _mm_loadu_si128((const __m128i*)(a + x + 2));
+        __m128i c0 = _mm_loadu_si128((const __m128i*)(c + x));
+        __m128i c2 = _mm_loadu_si128((const __m128i*)(c + x + 2));
+        __m128i n0 = _mm_loadu_si128((const __m128i*)(n + x));
+        __m128i n1 = _mm_loadu_si128((const __m128i*)(n + x + 1));
+        __m128i n2 = _mm_loadu_si128((const __m128i*)(n + x + 2));
+        
+        __m128i gx = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(a2, n2), _mm_mullo_epi16(c2, dos)),
+                                   _mm_add_epi16(_mm_add_epi16(a0, n0), _mm_mullo_epi16(c0, dos)));
+        __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(a0, a2), _mm_mullo_epi16(a1, dos)),
+                                   _mm_add_epi16(_mm_add_epi16(n0, n2), _mm_mullo_epi16(n1, dos)));
+        
+        __m128i lo = _mm_unpacklo_epi16(gx, gy);
+        __m128i hi = _mm_unpackhi_epi16(gx, gy);
+        __m128 mLo = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo)));
+        __m128 mHi = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi)));
+        mLo = _mm_add_ps(_mm_mul_ps(mLo, escala), medio);
+        mHi = _mm_add_ps(_mm_mul_ps(mHi, escala), medio);
+        __m128i m16 = _mm_packs_epi32(_mm_cvttps_epi32(mLo), _mm_cvttps_epi32(mHi));
+        _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(m16, m16));
+    }
+#endif
+    
+    for (; x < ancho; x++) {
+        int gx = (a[x + 2] + 2 * c[x + 2] + n[x + 2]) - (a[x] + 2 * c[x] + n[x]);
+        int gy = (a[x] + 2 * a[x + 1] + a[x + 2]) - (n[x] + 2 * n[x + 1] + n[x + 2]);
+        int m = gx * gx + gy * gy;
+        float mag = sqrtf((float)m) * (1.0f / (1 << SOBEL_BITS_LUMA)) + 0.5f;
+        dst[x] = (mag >= 255.0f) ? 255 : (unsigned char)mag;
+    }
+}
+
+// Sobel fusionado: cada fila de origen se convierte a luminancia una sola
+// vez en un buffer rotatorio de 3 filas, en lugar de nueve veces por píxel.
+void sobelWorker(void* arg, int inicio, int fin, int hiloId) {
+    SobelArgs* s = (SobelArgs*)arg;
+    size_t largo = (size_t)s->ancho + 2;
+    (void)hiloId;
+    
+    int16_t* buffer = malloc(3 * largo * sizeof(int16_t));
+    if (!buffer) {
+        atomic_fetch_add(&s->errores, 1);
+        return;
     }
     
-    return NULL;
+    int16_t* anterior = buffer;
+    int16_t* actual = buffer + largo;
+    int16_t* siguiente = buffer + 2 * largo;
+    
+    int yAnterior = (inicio > 0) ? inicio - 1 : 0;
+    filaALuma(s->src + (size_t)yAnterior * s->strideSrc, s->ancho, s->canales, anterior);
+    filaALuma(s->src + (size_t)inicio * s->strideSrc, s->ancho, s->canales, actual);
+    
+    for (int y = inicio; y < fin; y++) {
+        int ySiguiente = (y + 1 < s->alto) ? y + 1 : s->alto - 1;
+        filaALuma(s->src + (size_t)ySiguiente * s->strideSrc, s->ancho, s->canales, siguiente);
+        
+        sobelFila(anterior, actual, siguiente, s->ancho, s->dst + (size_t)y * s->strideDst);
+        
+        int16_t* libre = anterior;
+        anterior = actual;
+        actual = siguiente;
+        siguiente = libre;
+    }
+    
+    free(buffer);
 }
 
-float* generarKernelGauss(int tam, float sigma) {
-    if (tam % 2 == 0 || tam < 3) {
-        fprintf(stderr, "❌ Error: Tamaño de kernel inválido (%d)\n", tam);
-        return NULL;
+int detectarBordesSobelConcurrente(ImagenInfo* info, int numHilos) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
     }
     
-    int k2 = tam / 2;
-    float* kernel = malloc((size_t)tam * tam * sizeof(float));
-    if (!kernel) {
-        fprintf(stderr, "❌ Error: No se pudo asignar memoria para kernel\n");
-        return NULL;
+    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
+    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
+    
+    int ancho = info->ancho, alto = info->alto;
+    
+    printf("🔧 Detectando bordes (Sobel) con %d hilos...\n", numHilos);
+    printf("   Imagen de entrada: %dx%d, %d canales\n", ancho, alto, info->canales);
+    
+    ImagenInfo dst;
+    if (!crearImagen(&dst, ancho, alto, 1)) {
+        fprintf(stderr, "❌ Error: No se pudo crear matriz destino para Sobel\n");
+        return 0;
     }
     
-    float sum = 0.0f;
-    float denom = 2.0f * sigma * sigma;
+    SobelArgs args;
+    args.src = info->pixeles;
+    args.dst = dst.pixeles;
+    args.strideSrc = info->stride;
+    args.strideDst = dst.stride;
+    args.ancho = ancho;
+    args.alto = alto;
+    args.canales = info->canales;
+    atomic_init(&args.errores, 0);
+    
+    int hilosUsados = paraleloFilas(alto, numHilos, sobelWorker, &args);
+    
+    int errores = atomic_load(&args.errores);
+    if (errores > 0) {
+        fprintf(stderr, "❌ Error: Memoria insuficiente para Sobel (%d tareas fallidas)\n", errores);
+        liberarImagen(&dst);
+        return 0;
+    }
+    
+    liberarImagen(info);
+    *info = dst;
+    
+    printf("✓ Detección de bordes completada (%d hilos utilizados)\n", hilosUsados);
+    printf("   Imagen de salida: escala de grises (1 canal)\n");
+    return 1;
+}
+
+// ============================================================================
+// REDUCCIÓN 2:1 (PIRÁMIDE MIP)
+// ============================================================================
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int anchoDst, canales;
+} MitadArgs;
+
+#if defined(__SSE2__)
+// Suma cada par de píxeles vecinos (unidades de 'canales' lanes de 16 bits)
+// de dos vectores de sumas verticales y deja las 8 sumas compactadas.
+static inline __m128i sumarParesSSE2(__m128i a, __m128i b, int canales) {
+    switch (canales) {
+        case 1: {
+            const __m128i bajo = _mm_set1_epi32(0xFFFF);
+            a = _mm_and_si128(_mm_add_epi16(a, _mm_srli_epi32(a, 16)), bajo);
+            b = _mm_and_si128(_mm_add_epi16(b, _mm_srli_epi32(b, 16)), bajo);
+            return _mm_packs_epi32(a, b);
+        }
+        case 2:
+            a = _mm_shuffle_epi32(_mm_add_epi16(a, _mm_srli_epi64(a, 32)), _MM_SHUFFLE(3, 1, 2, 0));
+            b = _mm_shuffle_epi32(_mm_add_epi16(b, _mm_srli_epi64(b, 32)), _MM_SHUFFLE(3, 1, 2, 0));
+            return _mm_unpacklo_epi64(a, b);
+        default:
+            a = _mm_add_epi16(a, _mm_srli_si128(a, 8));
+            b = _mm_add_epi16(b, _mm_srli_si128(b, 8));
+            return _mm_unpacklo_epi64(a, b);
+    }
+}
+#endif
+
+// Promedio entero de bloques 2x2 con redondeo: (a + b + c + d + 2) >> 2.
+// Con 1, 2 o 4 canales los bloques de 16 bytes de salida van por SSE2;
+// el resto (y 3 canales, donde los píxeles no caen alineados) es escalar.
+static inline void reducirFilaMitad(const unsigned char* f0, const unsigned char* f1,
+                                    unsigned char* out, int anchoDst, int canales) {
+    size_t n = (size_t)anchoDst * canales;
+    size_t i = 0;
+    
+#if defined(__SSE2__)
+    if (canales != 3) {
+        const __m128i cero = _mm_setzero_si128();
+        const __m128i dos = _mm_set1_epi16(2);
+        for (; i + 16 <= n; i += 16) {
+            __m128i a0 = _mm_loadu_si128((const __m128i*)(f0 + 2 * i));
+            __m128i a1 = _mm_loadu_si128((const __m128i*)(f0 + 2 * i + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*)(f1 + 2 * i));
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(f1 + 2 * i + 16));
+            
+            __m128i v0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, cero), _mm_unpacklo_epi8(b0, cero));
+            __m128i v1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, cero), _mm_unpackhi_epi8(b0, cero));
+            __m128i v2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, cero), _mm_unpacklo_epi8(b1, cero));
+            __m128i v3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, cero), _mm_unpackhi_epi8(b1, cero));
+            
+            __m128i s0 = _mm_srli_epi16(_mm_add_epi16(sumarParesSSE2(v0, v1, canales), dos), 2);
+            __m128i s1 = _mm_srli_epi16(_mm_add_epi16(sumarParesSSE2(v2, v3, canales), dos), 2);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(s0, s1));
+        }
+    }
+#endif
+    
+    for (size_t x = i / canales; x < (size_t)anchoDst; x++) {
+        const unsigned char* p0 = f0 + 2 * x * canales;
+        const unsigned char* p1 = f1 + 2 * x * canales;
+        for (int c = 0; c < canales; c++) {
+            out[x * canales + c] = (unsigned char)((p0[c] + p0[c + canales] + p1[c] + p1[c + canales] + 2) >> 2);
+        }
+    }
+}
+
+void reducirMitadHilo(void* arg, int inicio, int fin, int hiloId) {
+    MitadArgs* m = (MitadArgs*)arg;
+    (void)hiloId;
+    
+    for (int y = inicio; y < fin; y++) {
+        const unsigned char* f0 = m->src + (size_t)(2 * y) * m->strideSrc;
+        const unsigned char* f1 = f0 + m->strideSrc;
+        unsigned char* out = m->dst + (size_t)y * m->strideDst;
+        
+        // Cantidad de canales constante para que el compilador desenrolle
+        switch (m->canales) {
+            case 1: reducirFilaMitad(f0, f1, out, m->anchoDst, 1); break;
+            case 2: reducirFilaMitad(f0, f1, out, m->anchoDst, 2); break;
+            case 3: reducirFilaMitad(f0, f1, out, m->anchoDst, 3); break;
+            default: reducirFilaMitad(f0, f1, out, m->anchoDst, 4); break;
+        }
+    }
+}
+
+// Reduce src a la mitad en cada eje (un nivel de la pirámide mip) y deja el
+// resultado en dst sin tocar src. Con dimensiones impares se descarta la
+// última fila/columna. Devuelve el número de hilos utilizados, o 0 si falla.
+static int reducirMitad(const ImagenInfo* src, ImagenInfo* dst, int numHilos) {
+    if (src->ancho < 2 || src->alto < 2) return 0;
+    if (!crearImagen(dst, src->ancho / 2, src->alto / 2, src->canales)) return 0;
+    
+    MitadArgs args;
+    args.src = src->pixeles;
+    args.dst = dst->pixeles;
+    args.strideSrc = src->stride;
+    args.strideDst = dst->stride;
+    args.anchoDst = dst->ancho;
+    args.canales = dst->canales;
+    
+    return paraleloFilas(dst->alto, numHilos, reducirMitadHilo, &args);
+}
+
+int reducirMitadConcurrente(ImagenInfo* info, int numHilos) {
+    if (!info || !info->pixeles) return 0;
+    
+    ImagenInfo dst;
+    int hilosUsados = reducirMitad(info, &dst, numHilos);
+    if (hilosUsados == 0) return 0;
+    
+    liberarImagen(info);
+    *info = dst;
+    return hilosUsados;
+}
+
+// ============================================================================
+// REDIMENSIONAR
+// ============================================================================
+
+// Tabla de remuestreo 1D: para cada índice de salida guarda numTaps pares
+// (índice de origen ya acotado al borde, peso). Se calcula una sola vez por
+// eje y se reutiliza en todas las filas (eje X) o columnas (eje Y).
+typedef struct {
+    int tamSalida;
+    int numTaps;
+    int* indices;   // tamSalida * numTaps
+    float* pesos;   // tamSalida * numTaps
+} TablaRemuestreo;
+
+void liberarTablaRemuestreo(TablaRemuestreo* t) {
+    if (!t) return;
+    free(t->indices);
+    free(t->pesos);
+    t->indices = NULL;
+    t->pesos = NULL;
+}
+
+static int reservarTablaRemuestreo(TablaRemuestreo* t, int tamSalida, int numTaps) {
+    size_t n = (size_t)tamSalida * numTaps;
+    t->tamSalida = tamSalida;
+    t->numTaps = numTaps;
+    t->indices = (int*)malloc(n * sizeof(int));
+    t->pesos = (float*)malloc(n * sizeof(float));
+    if (!t->indices || !t->pesos) {
+        liberarTablaRemuestreo(t);
+        return 0;
+    }
+    return 1;
+}
+
+// Taps bilineales con centros alineados: f = (i + 0.5) * escala - 0.5.
+// Los pesos (1 - d, d) y el orden de los taps coinciden con la interpolación
+// bilineal directa, así que el resultado separable es idéntico.
+int construirTablaBilineal(TablaRemuestreo* t, int tamOrigen, int tamSalida) {
+    if (!reservarTablaRemuestreo(t, tamSalida, 2)) return 0;
+    
+    float escala = (float)tamOrigen / (float)tamSalida;
+    for (int i = 0; i < tamSalida; i++) {
+        float f = (i + 0.5f) * escala - 0.5f;
+        int i0 = (int)floorf(f);
+        float d = f - i0;
+        int i1 = i0 + 1;
+        
+        if (i0 < 0) i0 = 0;
+        if (i0 > tamOrigen - 1) i0 = tamOrigen - 1;
+        if (i1 > tamOrigen - 1) i1 = tamOrigen - 1;
+        
+        t->indices[2 * i] = i0;
+        t->indices[2 * i + 1] = i1;
+        t->pesos[2 * i] = 1 - d;
+        t->pesos[2 * i + 1] = d;
+    }
+    return 1;
+}
+
+// Promedio por área (filtro caja): cada salida cubre el intervalo
+// [i * escala, (i + 1) * escala) del origen y cada píxel de origen pesa
+// según la fracción de ese intervalo que solapa. Con reducciones grandes
+// todos los píxeles de origen contribuyen, lo que evita el aliasing.
+int construirTablaArea(TablaRemuestreo* t, int tamOrigen, int tamSalida) {
+    double escala = (double)tamOrigen / (double)tamSalida;
+    // Con escala entera las ventanas caen alineadas y sobra el tap extra
+    int numTaps = (int)ceil(escala) + (escala != floor(escala) ? 1 : 0);
+    if (!reservarTablaRemuestreo(t, tamSalida, numTaps)) return 0;
+    
+    for (int i = 0; i < tamSalida; i++) {
+        double a = i * escala;
+        double b = a + escala;
+        int j0 = (int)floor(a);
+        int j1 = (int)ceil(b);
+        if (j1 > tamOrigen) j1 = tamOrigen;
+        
+        int* idx = t->indices + (size_t)i * numTaps;
+        float* w = t->pesos + (size_t)i * numTaps;
+        int k = 0;
+        for (int j = j0; j < j1 && k < numTaps; j++) {
+            double solape = fmin(b, j + 1.0) - fmax(a, (double)j);
+            if (solape <= 0.0) continue;
+            idx[k] = j;
+            w[k] = (float)(solape / escala);
+            k++;
+        }
+        
+        // Relleno con peso cero para que todas las salidas tengan numTaps
+        for (int last = k > 0 ? idx[k - 1] : j0; k < numTaps; k++) {
+            idx[k] = last;
+            w[k] = 0.0f;
+        }
+    }
+    return 1;
+}
+
+// Núcleo cúbico de Mitchell-Netravali con parámetros (B, C); soporte 2.
+static double nucleoCubico(double x, double B, double C) {
+    x = fabs(x);
+    if (x < 1.0) {
+        return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.0;
+    }
+    if (x < 2.0) {
+        return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0;
+    }
+    return 0.0;
+}
+
+static double nucleoCatmullRom(double x) { return nucleoCubico(x, 0.0, 0.5); }
+static double nucleoMitchell(double x) { return nucleoCubico(x, 1.0 / 3.0, 1.0 / 3.0); }
+
+static double senoCardinal(double x) {
+    if (fabs(x) < 1e-8) return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+// Lanczos de 3 lóbulos: sinc(x) * sinc(x / 3); soporte 3.
+static double nucleoLanczos3(double x) {
+    if (fabs(x) >= 3.0) return 0.0;
+    return senoCardinal(x) * senoCardinal(x / 3.0);
+}
+
+// Tabla a partir de un núcleo continuo con el soporte dado. Al reducir el
+// núcleo se estira por la escala (actúa como filtro paso bajo); los pesos
+// de cada salida se normalizan para que sumen 1 y los índices fuera de la
+// imagen se acotan al borde.
+static int construirTablaNucleo(TablaRemuestreo* t, int tamOrigen, int tamSalida,
+                                double (*nucleo)(double), double soporte) {
+    double escala = (double)tamOrigen / (double)tamSalida;
+    double ancho = escala > 1.0 ? escala : 1.0;
+    double radio = soporte * ancho;
+    int numTaps = (int)ceil(2.0 * radio) + 1;
+    if (!reservarTablaRemuestreo(t, tamSalida, numTaps)) return 0;
+    
+    for (int i = 0; i < tamSalida; i++) {
+        double centro = (i + 0.5) * escala - 0.5;
+        int j0 = (int)ceil(centro - radio);
+        int* idx = t->indices + (size_t)i * numTaps;
+        float* w = t->pesos + (size_t)i * numTaps;
+        
+        double suma = 0.0;
+        for (int k = 0; k < numTaps; k++) {
+            suma += nucleo((j0 + k - centro) / ancho);
+        }
+        if (suma == 0.0) suma = 1.0;
+        
+        for (int k = 0; k < numTaps; k++) {
+            int j = j0 + k;
+            idx[k] = j < 0 ? 0 : (j > tamOrigen - 1 ? tamOrigen - 1 : j);
+            w[k] = (float)(nucleo((j0 + k - centro) / ancho) / suma);
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    const unsigned char* src;
+    unsigned char* dst;
+    size_t strideSrc, strideDst;
+    int anchoSrc, canales;
+    const TablaRemuestreo* tx;
+    const TablaRemuestreo* ty;
+    atomic_int errores;          // tareas sin memoria para su fila
+} ResizeArgs;
+
+// Pasada vertical: acumula en fila (float) la combinación de las filas de
+// origen indicadas por los taps. Es contigua, así que va por SSE2.
+static void combinarFilasV(const ResizeArgs* r, const int* idx, const float* w, float* fila, size_t n) {
+    const int taps = r->ty->numTaps;
+    size_t i0 = 0;
+    
+#if defined(__SSE2__)
+    const __m128i cero = _mm_setzero_si128();
+    size_t nv = n & ~(size_t)15;
+    for (size_t i = 0; i < nv; i += 16) {
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+        for (int k = 0; k < taps; k++) {
+            const unsigned char* p = r->src + (size_t)idx[k] * r->strideSrc + i;
+            __m128 wk = _mm_set1_ps(w[k]);
+            __m128i v = _mm_loadu_si128((const __m128i*)p);
+            __m128i lo = _mm_unpacklo_epi8(v, cero), hi = _mm_unpackhi_epi8(v, cero);
+            a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, cero)), wk));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, cero)), wk));
+            a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, cero)), wk));
+            a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, cero)), wk));
+        }
+        _mm_storeu_ps(fila + i, a0);
+        _mm_storeu_ps(fila + i + 4, a1);
+        _mm_storeu_ps(fila + i + 8, a2);
+        _mm_storeu_ps(fila + i + 12, a3);
+    }
+    i0 = nv;
+#endif
+    
+    for (size_t i = i0; i < n; i++) {
+        float acc = 0.0f;
+        for (int k = 0; k < taps; k++) {
+            acc += r->src[(size_t)idx[k] * r->strideSrc + i] * w[k];
+        }
+        fila[i] = acc;
+    }
+}
+
+// Pasada horizontal sobre la fila ya combinada; escribe la fila destino.
+static inline void combinarFilaH(const float* fila, unsigned char* out, const TablaRemuestreo* tx, int canales) {
+    const int taps = tx->numTaps;
+    for (int x = 0; x < tx->tamSalida; x++) {
+        const int* idx = tx->indices + (size_t)x * taps;
+        const float* w = tx->pesos + (size_t)x * taps;
+        for (int c = 0; c < canales; c++) {
+            float acc = 0.0f;
+            for (int k = 0; k < taps; k++) {
+                acc += fila[(size_t)idx[k] * canales + c] * w[k];
+            }
+            out[(size_t)x * canales + c] = clampuc((int)roundf(acc));
+        }
+    }
+}
+
+// Cada fila destino se produce completa en un buffer de una fila por hilo:
+// primero la pasada vertical sobre las filas de origen que la afectan y
+// luego la horizontal, sin búfer intermedio del tamaño de la imagen.
+void resizeWorker(void* arg, int inicio, int fin, int hiloId) {
+    ResizeArgs* r = (ResizeArgs*)arg;
+    size_t n = (size_t)r->anchoSrc * r->canales;
+    const int taps = r->ty->numTaps;
+    (void)hiloId;
+    
+    float* fila = (float*)malloc(n * sizeof(float));
+    if (!fila) {
+        atomic_fetch_add(&r->errores, 1);
+        return;
+    }
+    
+    for (int y = inicio; y < fin; y++) {
+        combinarFilasV(r, r->ty->indices + (size_t)y * taps, r->ty->pesos + (size_t)y * taps, fila, n);
+        
+        unsigned char* filaDst = r->dst + (size_t)y * r->strideDst;
+        // Cantidad de canales constante para que el compilador desenrolle
+        switch (r->canales) {
+            case 1: combinarFilaH(fila, filaDst, r->tx, 1); break;
+            case 2: combinarFilaH(fila, filaDst, r->tx, 2); break;
+            case 3: combinarFilaH(fila, filaDst, r->tx, 3); break;
+            default: combinarFilaH(fila, filaDst, r->tx, 4); break;
+        }
+    }
+    
+    free(fila);
+}
+
+// Motor separable con tablas de taps precalculadas. Devuelve el número de
+// hilos utilizados, o 0 si alguna tarea no pudo reservar su fila.
+static int remuestrearSeparable(const ImagenInfo* src, ImagenInfo* dst, const TablaRemuestreo* tx,
+                                const TablaRemuestreo* ty, int numHilos) {
+    ResizeArgs args;
+    args.src = src->pixeles;
+    args.dst = dst->pixeles;
+    args.strideSrc = src->stride;
+    args.strideDst = dst->stride;
+    args.anchoSrc = src->ancho;
+    args.canales = dst->canales;
+    args.tx = tx;
+    args.ty = ty;
+    atomic_init(&args.errores, 0);
+    
+    int hilosUsados = paraleloFilas(dst->alto, numHilos, resizeWorker, &args);
+    return atomic_load(&args.errores) > 0 ? 0 : hilosUsados;
+}
+
+typedef enum {
+    FILTRO_AUTO = 0,    // área + pirámide mip al reducir, bilineal al ampliar
+    FILTRO_BILINEAL,
+    FILTRO_AREA,
+    FILTRO_CATMULL_ROM,
+    FILTRO_MITCHELL,
+    FILTRO_LANCZOS3
+} FiltroResize;
+
+const char* nombreFiltro(FiltroResize filtro) {
+    switch (filtro) {
+        case FILTRO_AUTO: return "automático";
+        case FILTRO_BILINEAL: return "bilineal";
+        case FILTRO_AREA: return "área";
+        case FILTRO_CATMULL_ROM: return "bicúbico Catmull-Rom";
+        case FILTRO_MITCHELL: return "bicúbico Mitchell";
+        case FILTRO_LANCZOS3: return "Lanczos-3";
+        default: return "desconocido";
+    }
+}
+
+static int construirTablaFiltro(TablaRemuestreo* t, FiltroResize filtro, int tamOrigen, int tamSalida) {
+    switch (filtro) {
+        case FILTRO_AREA: return construirTablaArea(t, tamOrigen, tamSalida);
+        case FILTRO_CATMULL_ROM: return construirTablaNucleo(t, tamOrigen, tamSalida, nucleoCatmullRom, 2.0);
+        case FILTRO_MITCHELL: return construirTablaNucleo(t, tamOrigen, tamSalida, nucleoMitchell, 2.0);
+        case FILTRO_LANCZOS3: return construirTablaNucleo(t, tamOrigen, tamSalida, nucleoLanczos3, 3.0);
+        default: return construirTablaBilineal(t, tamOrigen, tamSalida);
+    }
+}
+
+// ============================================================================
+// CACHÉ DE TABLAS DE REMUESTREO
+// ============================================================================
+
+#define CACHE_TABLAS_MAX 16
+
+// Las tablas de cada eje dependen solo de (filtro, tamaño origen, tamaño
+// destino), así que los resize repetidos de imágenes del mismo tamaño (por
+// ejemplo en lotes) reutilizan los pesos. Cada entrada lleva un contador de
+// referencias: solo se desaloja una entrada que nadie está usando.
+typedef struct {
+    int valida;
+    FiltroResize filtro;
+    int tamOrigen, tamSalida;
+    int referencias;
+    unsigned long ultimoUso;
+    TablaRemuestreo tabla;
+} EntradaCacheTablas;
+
+static struct {
+    pthread_mutex_t mutex;
+    EntradaCacheTablas entradas[CACHE_TABLAS_MAX];
+    unsigned long reloj;
+} cacheTablas = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+// Devuelve la tabla del eje (construyéndola si no está) con una referencia
+// tomada; hay que devolverla con soltarTablaCache. NULL si falta memoria.
+const TablaRemuestreo* obtenerTablaCache(FiltroResize filtro, int tamOrigen, int tamSalida) {
+    pthread_mutex_lock(&cacheTablas.mutex);
+    cacheTablas.reloj++;
+    
+    EntradaCacheTablas* libre = NULL;
+    for (int i = 0; i < CACHE_TABLAS_MAX; i++) {
+        EntradaCacheTablas* e = &cacheTablas.entradas[i];
+        if (e->valida && e->filtro == filtro && e->tamOrigen == tamOrigen && e->tamSalida == tamSalida) {
+            e->referencias++;
+            e->ultimoUso = cacheTablas.reloj;
+            pthread_mutex_unlock(&cacheTablas.mutex);
+            return &e->tabla;
+        }
+        // Candidata a reemplazo: vacía o la menos usada recientemente sin referencias
+        if (!e->valida) {
+            if (!libre || libre->valida) libre = e;
+        } else if (e->referencias == 0 && (!libre || (libre->valida && e->ultimoUso < libre->ultimoUso))) {
+            libre = e;
+        }
+    }
     
-    for (int y = -k2; y <= k2; y++) {
-        for (int x = -k2; x <= k2; x++) {
-            float val = expf(-((float)(x * x + y * y)) / denom) / (M_PI * denom);
-            kernel[(y + k2) * tam + (x + k2)] = val;
-            sum += val;
+    if (libre) {
+        if (libre->valida) liberarTablaRemuestreo(&libre->tabla);
+        libre->valida = 0;
+        if (!construirTablaFiltro(&libre->tabla, filtro, tamOrigen, tamSalida)) {
+            pthread_mutex_unlock(&cacheTablas.mutex);
+            return NULL;
         }
+        libre->valida = 1;
+        libre->filtro = filtro;
+        libre->tamOrigen = tamOrigen;
+        libre->tamSalida = tamSalida;
+        libre->referencias = 1;
+        libre->ultimoUso = cacheTablas.reloj;
+        pthread_mutex_unlock(&cacheTablas.mutex);
+        return &libre->tabla;
     }
+    pthread_mutex_unlock(&cacheTablas.mutex);
     
-    if (sum > 0.0f) {
-        for (int i = 0; i < tam * tam; i++) {
-            kernel[i] /= sum;
+    // Caché llena de tablas en uso: tabla propia fuera de la caché
+    TablaRemuestreo* t = (TablaRemuestreo*)malloc(sizeof(TablaRemuestreo));
+    if (!t) return NULL;
+    if (!construirTablaFiltro(t, filtro, tamOrigen, tamSalida)) {
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void soltarTablaCache(const TablaRemuestreo* tabla) {
+    if (!tabla) return;
+    
+    pthread_mutex_lock(&cacheTablas.mutex);
+    for (int i = 0; i < CACHE_TABLAS_MAX; i++) {
+        EntradaCacheTablas* e = &cacheTablas.entradas[i];
+        if (e->valida && &e->tabla == tabla) {
+            e->referencias--;
+            pthread_mutex_unlock(&cacheTablas.mutex);
+            return;
         }
-    } else {
-        for (int i = 0; i < tam * tam; i++) kernel[i] = 0.0f;
-        kernel[k2 * tam + k2] = 1.0f;
     }
+    pthread_mutex_unlock(&cacheTablas.mutex);
     
-    return kernel;
+    TablaRemuestreo* t = (TablaRemuestreo*)tabla;
+    liberarTablaRemuestreo(t);
+    free(t);
 }
 
-void aplicarConvolucionConcurrente(ImagenInfo* info, int tamKernel, float sigma, int numHilos) {
-    if (!info || !info->pixeles) {
-        printf("❌ No hay imagen cargada\n");
-        return;
+void liberarCacheTablas(void) {
+    pthread_mutex_lock(&cacheTablas.mutex);
+    for (int i = 0; i < CACHE_TABLAS_MAX; i++) {
+        EntradaCacheTablas* e = &cacheTablas.entradas[i];
+        if (e->valida) liberarTablaRemuestreo(&e->tabla);
+        e->valida = 0;
+    }
+    pthread_mutex_unlock(&cacheTablas.mutex);
+}
+
+// Remuestrea src en dst (ya creada) con el filtro indicado. Devuelve el
+// número de hilos utilizados, o 0 si falta memoria.
+static int remuestrearConFiltro(const ImagenInfo* src, ImagenInfo* dst, FiltroResize filtro, int numHilos) {
+    const TablaRemuestreo* tx = obtenerTablaCache(filtro, src->ancho, dst->ancho);
+    const TablaRemuestreo* ty = obtenerTablaCache(filtro, src->alto, dst->alto);
+    int hilosUsados = 0;
+    
+    if (tx && ty) {
+        hilosUsados = remuestrearSeparable(src, dst, tx, ty, numHilos);
     }
     
-    if (tamKernel % 2 == 0 || tamKernel < 3) {
-        printf("❌ Error: El tamaño del kernel debe ser impar y >= 3\n");
-        return;
+    soltarTablaCache(tx);
+    soltarTablaCache(ty);
+    return hilosUsados;
+}
+
+int redimensionarConcurrente(ImagenInfo* info, int nuevoAncho, int nuevoAlto, int numHilos, FiltroResize filtro) {
+    if (!info || !info->pixeles) {
+        printf("❌ No hay imagen cargada\n");
+        return 0;
     }
     
-    if (sigma <= 0.0f) {
-        printf("⚠ Sigma inválido, usando 1.0\n");
-        sigma = 1.0f;
+    if (nuevoAncho <= 0 || nuevoAlto <= 0) {
+        printf("❌ Error: Dimensiones inválidas (%dx%d)\n", nuevoAncho, nuevoAlto);
+        return 0;
     }
     
     if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
     if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
-    if (numHilos > info->alto) numHilos = info->alto;
     
-    printf("🔧 Aplicando convolución Gaussiana (kernel %dx%d, σ=%.2f) con %d hilos...\n", 
-           tamKernel, tamKernel, sigma, numHilos);
+    int anchoSrc = info->ancho, altoSrc = info->alto;
+    int usarPiramide = 0;
+    if (filtro == FILTRO_AUTO) {
+        usarPiramide = nuevoAncho <= anchoSrc && nuevoAlto <= altoSrc;
+        filtro = usarPiramide ? FILTRO_AREA : FILTRO_BILINEAL;
+    }
     
-    float* kernel = generarKernelGauss(tamKernel, sigma);
-    if (!kernel) return;
+    printf("🔧 Redimensionando imagen de %dx%d a %dx%d con %d hilos (filtro %s)...\n",
+           anchoSrc, altoSrc, nuevoAncho, nuevoAlto, numHilos, nombreFiltro(filtro));
+    
+    // Niveles 2:1 exactos mientras ambos ejes sean pares y sigan siendo al
+    // menos el doble del destino; el resto de la reducción lo hace el área.
+    ImagenInfo actual = *info;
+    int niveles = 0, hilosUsados = 0;
+    while (usarPiramide && actual.ancho % 2 == 0 && actual.alto % 2 == 0 &&
+           actual.ancho >= 2 * nuevoAncho && actual.alto >= 2 * nuevoAlto) {
+        ImagenInfo sig;
+        int h = reducirMitad(&actual, &sig, numHilos);
+        if (h == 0) break;
+        if (actual.pixeles != info->pixeles) liberarImagen(&actual);
+        actual = sig;
+        niveles++;
+        if (h > hilosUsados) hilosUsados = h;
+    }
     
-    unsigned char*** dst = crearMatrizPixeles(info->alto, info->ancho, info->canales);
-    if (!dst) {
-        fprintf(stderr, "❌ Error: No se pudo crear matriz destino\n");
-        free(kernel);
-        return;
+    ImagenInfo dst = actual;
+    if (niveles == 0 || actual.ancho != nuevoAncho || actual.alto != nuevoAlto) {
+        if (!crearImagen(&dst, nuevoAncho, nuevoAlto, info->canales)) {
+            fprintf(stderr, "❌ Error: No se pudo crear matriz destino para resize\n");
+            if (actual.pixeles != info->pixeles) liberarImagen(&actual);
+            return 0;
+        }
+        
+        int h = remuestrearConFiltro(&actual, &dst, filtro, numHilos);
+        if (actual.pixeles != info->pixeles) liberarImagen(&actual);
+        if (h == 0) {
+            fprintf(stderr, "❌ Error: Memoria insuficiente para el remuestreo\n");
+            liberarImagen(&dst);
+            return 0;
+        }
+        if (h > hilosUsados) hilosUsados = h;
     }
     
-    pthread_t* hilos = malloc(sizeof(pthread_t) * (size_t)numHilos);
-    ConvArgs* args = malloc(sizeof(ConvArgs) * (size_t)numHilos);
+    if (dst.pixeles != info->pixeles) {
+        liberarImagen(info);
+        *info = dst;
+    }
     
-    if (!hilos || !args) {
-        fprintf(stderr, "❌ Error: Memoria insuficiente para hilos\n");
-        free(hilos);
-        free(args);
-        free(kernel);
-        freeMatriz(dst, info->alto, info->ancho);
-        return;
+    if (niveles > 0) {
+        printf("   ↳ %d nivel(es) de pirámide mip 2:1 antes del filtro de área\n", niveles);
     }
+    printf("✓ Redimensionamiento completado (%d hilos utilizados)\n", hilosUsados);
+    return 1;
+}
+
+// ============================================================================
+// BENCHMARKS
+// ============================================================================
+
+// Imagen de prueba determinista: gradientes, bordes duros y ruido.
+int generarImagenSintetica(ImagenInfo* info, int ancho, int alto, int canales) {
+    if (!crearImagen(info, ancho, alto, canales)) return 0;
     
-    int filas = (info->alto + numHilos - 1) / numHilos;
-    int hilosCreados = 0;
-    
-    for (int i = 0; i < numHilos; i++) {
-        args[i].src = info->pixeles;
-        args[i].dst = dst;
-        args[i].inicio = i * filas;
-        args[i].fin = ((i + 1) * filas < info->alto) ? (i + 1) * filas : info->alto;
-        args[i].ancho = info->ancho;
-        args[i].alto = info->alto;
-        args[i].canales = info->canales;
-        args[i].tamKernel = tamKernel;
-        args[i].kernel = kernel;
-        args[i].hiloId = i;
-        
-        if (args[i].inicio < args[i].fin) {
-            if (pthread_create(&hilos[i], NULL, aplicarConvolucionHilo, &args[i]) != 0) {
-                fprintf(stderr, "⚠ Advertencia: No se pudo crear hilo %d\n", i);
-                args[i].inicio = args[i].fin;
-            } else {
-                hilosCreados++;
+    uint32_t semilla = 2463534242u;
+    for (int y = 0; y < alto; y++) {
+        unsigned char* fila = filaPixeles(info, y);
+        for (int x = 0; x < ancho; x++) {
+            int cuadro = ((x / 64) + (y / 64)) % 2 ? 96 : 0;
+            for (int c = 0; c < canales; c++) {
+                semilla ^= semilla << 13;
+                semilla ^= semilla >> 17;
+                semilla ^= semilla << 5;
+                int v = (x * 255 / ancho) / (c + 1) + (y * 255 / alto) / 2 + cuadro + (int)(semilla & 31);
+                fila[(size_t)x * canales + c] = clampuc(v);
             }
         }
     }
-    
-    for (int i = 0; i < numHilos; i++) {
-        if (args[i].inicio < args[i].fin) {
-            pthread_join(hilos[i], NULL);
+    return 1;
+}
+
+// Compara el Sobel de referencia (float, luminancia por vecino) con el
+// fusionado (buffer rotatorio de luminancia, enteros y SSE2) en 4K y 8K.
+int benchSobel(int numHilos) {
+    const int tamanos[][2] = {{3840, 2160}, {7680, 4320}};
+    const char* nombres[] = {"4K", "8K"};
+    const int repeticiones = 5;
+    
+    printf("Benchmark Sobel (%d hilos, mejor de %d repeticiones)\n", numHilos, repeticiones);
+    printf("%-4s %12s %12s %12s %12s %9s\n", "Res", "ref (ms)", "ref MP/s", "fus (ms)", "fus MP/s", "speedup");
+    
+    for (int t = 0; t < 2; t++) {
+        int ancho = tamanos[t][0], alto = tamanos[t][1];
+        ImagenInfo src, dst;
+        if (!generarImagenSintetica(&src, ancho, alto, 3)) return EXIT_FAILURE;
+        if (!crearImagen(&dst, ancho, alto, 1)) {
+            liberarImagen(&src);
+            return EXIT_FAILURE;
+        }
+        
+        SobelArgs args;
+        args.src = src.pixeles;
+        args.dst = dst.pixeles;
+        args.strideSrc = src.stride;
+        args.strideDst = dst.stride;
+        args.ancho = ancho;
+        args.alto = alto;
+        args.canales = 3;
+        atomic_init(&args.errores, 0);
+        
+        TareaFilas tareas[2] = {sobelReferenciaHilo, sobelWorker};
+        double mejor[2] = {1e30, 1e30};
+        for (int k = 0; k < 2; k++) {
+            for (int r = 0; r < repeticiones; r++) {
+                double t0 = tiempoActual();
+                paraleloFilas(alto, numHilos, tareas[k], &args);
+                double dt = tiempoActual() - t0;
+                if (dt < mejor[k]) mejor[k] = dt;
+            }
         }
+        
+        double mp = (double)ancho * alto / 1e6;
+        printf("%-4s %12.2f %12.1f %12.2f %12.1f %8.1fx\n", nombres[t],
+               mejor[0] * 1e3, mp / mejor[0], mejor[1] * 1e3, mp / mejor[1], mejor[0] / mejor[1]);
+        
+        liberarImagen(&src);
+        liberarImagen(&dst);
     }
     
-    int ancho_orig = info->ancho;
-    int alto_orig = info->alto;
-    int canales_orig = info->canales;
+    return EXIT_SUCCESS;
+}
+
+// Tabla de velocidad (MB/s de imagen sin comprimir) frente a tamaño para
+// varias combinaciones de nivel y filtro, más stb_image_write como
+// referencia. Codifica en memoria, sin escribir a disco.
+int benchPNG(int numHilos, const char* ruta) {
+    ImagenInfo img = {0, 0, 0, 0, NULL};
+    const int repeticiones = 3;
+    
+    if (ruta) {
+        if (!cargarImagen(ruta, &img, 1)) return EXIT_FAILURE;
+    } else if (!generarImagenSintetica(&img, 3840, 2160, 3)) {
+        return EXIT_FAILURE;
+    }
     
-    liberarImagen(info);
-    info->pixeles = dst;
-    info->ancho = ancho_orig;
-    info->alto = alto_orig;
-    info->canales = canales_orig;
+    double mb = (double)img.ancho * img.alto * img.canales / 1e6;
+    printf("Benchmark PNG: %dx%d, %d canales (%.1f MB sin comprimir), %d hilos, mejor de %d\n",
+           img.ancho, img.alto, img.canales, mb, numHilos, repeticiones);
+    printf("%-6s %-10s %10s %10s %12s %8s\n", "Nivel", "Filtro", "ms", "MB/s", "Tamaño KB", "Ratio");
+    
+    const int casos[][2] = {
+        {0, 0}, {0, FILTRO_PNG_ADAPTATIVO},
+        {1, 0}, {1, 1}, {1, 2}, {1, 3}, {1, 4}, {1, FILTRO_PNG_ADAPTATIVO},
+        {3, FILTRO_PNG_ADAPTATIVO}, {6, 2}, {6, FILTRO_PNG_ADAPTATIVO}, {9, FILTRO_PNG_ADAPTATIVO},
+    };
+    
+    for (size_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++) {
+        OpcionesPNG op = {casos[c][0], casos[c][1]};
+        double mejor = 1e30;
+        size_t tam = 0;
+        for (int r = 0; r < repeticiones; r++) {
+            PNGCodificado png;
+            double t0 = tiempoActual();
+            if (!codificarPNG(&img, &op, numHilos, &png)) {
+                liberarImagen(&img);
+                return EXIT_FAILURE;
+            }
+            double dt = tiempoActual() - t0;
+            if (dt < mejor) mejor = dt;
+            tam = tamArchivoPNG(&png);
+            liberarPNGCodificado(&png);
+        }
+        printf("%-6d %-10s %10.1f %10.1f %12.1f %7.1f%%\n", op.nivel,
+               op.filtro == FILTRO_PNG_ADAPTATIVO ? "adaptive" : nombresFiltroPNG[op.filtro],
+               mejor * 1e3, mb / mejor, tam / 1024.0, 100.0 * tam / (mb * 1e6));
+    }
     
-    free(hilos);
-    free(args);
-    free(kernel);
-    printf("✓ Convolución aplicada correctamente (%d hilos utilizados)\n", hilosCreados);
+    if (img.stride <= (size_t)INT_MAX) {
+        double mejor = 1e30;
+        int tam = 0;
+        for (int r = 0; r < repeticiones; r++) {
+            double t0 = tiempoActual();
+            unsigned char* mem = stbi_write_png_to_mem(img.pixeles, (int)img.stride, img.ancho, img.alto,
+                                                       img.canales, &tam);
+            double dt = tiempoActual() - t0;
+            if (dt < mejor) mejor = dt;
+            free(mem);
+        }
+        printf("%-6s %-10s %10.1f %10.1f %12.1f %7.1f%%\n", "stb", "adaptive",
+               mejor * 1e3, mb / mejor, tam / 1024.0, 100.0 * tam / (mb * 1e6));
+    }
+    
+    liberarImagen(&img);
+    return EXIT_SUCCESS;
 }
 
 // ============================================================================
-// ROTACIÓN
+// MODO LÍNEA DE COMANDOS (PIPELINE)
 // ============================================================================
 
+#define MAX_PASOS 64
+#define MAX_HILOS_ES 16     // decodificadores/codificadores del modo lote
+
+typedef enum {
+    PASO_BRILLO,
+    PASO_CONTRASTE,
+    PASO_GAMMA,
+    PASO_INVERTIR,
+    PASO_UMBRAL,
+    PASO_DESENFOQUE,
+    PASO_DESENFOQUE_RAPIDO,
+    PASO_ROTAR,
+    PASO_VOLTEAR,
+    PASO_SOBEL,
+    PASO_REDIMENSIONAR,
+    PASO_GUARDAR
+} TipoPaso;
+
+static const char* nombresPaso[] = {
+    "brillo", "contraste", "gamma", "invertir", "umbral", "desenfoque", "desenfoque rápido",
+    "rotar", "voltear", "sobel", "redimensionar", "guardar"
+};
+
 typedef struct {
-    unsigned char*** pixelesOrigen;
-    unsigned char*** pixelesDestino;
-    int inicio, fin;
-    int anchoOrigen, altoOrigen, canales;
-    int anchoDestino, altoDestino;
-    float cosA, sinA;
-    float minX, minY;
-    float cx, cy;
-    int hiloId;
-} RotArgs;
+    TipoPaso tipo;
+    int entero1, entero2;       // delta, umbral, tamaño de kernel, ancho/alto, volteo H/V
+    float real;                 // contraste, gamma, sigma, ángulo
+    FiltroResize filtro;
+    const char* ruta;           // --save
+} PasoPipeline;
 
-void* rotarWorker(void* arg) {
-    RotArgs* r = (RotArgs*)arg;
-    unsigned char out_local[4];
-    
-    for (int y = r->inicio; y < r->fin; y++) {
-        for (int x = 0; x < r->anchoDestino; x++) {
-            float X = (float)x + r->minX;
-            float Y = (float)y + r->minY;
-            
-            float sx = r->cosA * (X - r->cx) + r->sinA * (Y - r->cy) + r->cx;
-            float sy = -r->sinA * (X - r->cx) + r->cosA * (Y - r->cy) + r->cy;
-            
-            if (sx >= 0.0f && sx < (float)r->anchoOrigen && 
-                sy >= 0.0f && sy < (float)r->altoOrigen) {
-                sampleBilinear(r->pixelesOrigen, r->anchoOrigen, r->altoOrigen, 
-                              r->canales, sx, sy, out_local);
-                for (int c = 0; c < r->canales; c++) {
-                    r->pixelesDestino[y][x][c] = out_local[c];
-                }
-            } else {
-                for (int c = 0; c < r->canales; c++) {
-                    r->pixelesDestino[y][x][c] = 0;
+typedef struct {
+    const char* entrada;
+    const char* lote;           // --batch: directorio o lista de rutas
+    const char* dirSalida;      // --out-dir
+    int hilosES;                // --io-threads: decodificadores y codificadores del lote
+    int conservarAlfa;
+    int numHilos;
+    OpcionesPNG png;            // --png-level / --png-filter
+    const char* rutaMetricas;   // --metrics: informe JSON por operación
+    int perfilHardware;         // --perf: contadores hardware por operación
+    const char* rutaTraza;      // --trace: línea de tiempo en formato Chrome Trace
+    int numPasos;
+    PasoPipeline pasos[MAX_PASOS];
+} Pipeline;
+
+void mostrarUsoLineaComandos(const char* programa) {
+    printf("Uso: %s entrada.png [opciones...]\n", programa);
+    printf("Las operaciones se ejecutan en el orden en que aparecen:\n");
+    printf("  --brightness N        Brillo (-255..255)\n");
+    printf("  --contrast F          Contraste (0..4)\n");
+    printf("  --gamma F             Gamma (0.1..5)\n");
+    printf("  --invert              Negativo\n");
+    printf("  --threshold N         Umbral (0..255)\n");
+    printf("  --blur K[:S]          Gaussiano de kernel K (impar, 3..51) y sigma S\n");
+    printf("  --fast-blur S         Gaussiano aproximado con tres cajas (sigma 0.5..50)\n");
+    printf("  --rotate A            Rotación en grados (-360..360)\n");
+    printf("  --flip h|v|hv         Volteo horizontal, vertical o ambos\n");
+    printf("  --sobel               Detección de bordes\n");
+    printf("  --resize WxH[:F]      Redimensionar; F = auto|bilinear|area|catmull|mitchell|lanczos\n");
+    printf("  --save RUTA           Guardar PNG (puede repetirse)\n");
+    printf("Procesamiento por lotes (sin imagen de entrada ni --save):\n");
+    printf("  --batch ORIGEN        Directorio de imágenes o archivo con una ruta por línea\n");
+    printf("  --out-dir DIR         Directorio donde se guardan los PNG resultantes\n");
+    printf("  --io-threads N        Hilos de decodificación y de codificación (1..%d, por defecto 2)\n", MAX_HILOS_ES);
+    printf("Opciones generales:\n");
+    printf("  --threads N           Hilos (%d..%d, por defecto %d)\n", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
+    printf("  --keep-alpha          Conservar el canal alfa al cargar\n");
+    printf("  --png-level N         Compresión PNG (0 = sin comprimir, 1 = rápido ... 9 = máximo; por defecto %d)\n",
+           NIVEL_PNG_DEFECTO);
+    printf("  --png-filter F        Filtro de filas PNG: adaptive|none|sub|up|average|paeth\n");
+    printf("  --metrics RUTA        Guardar en JSON tiempos, ocupación por hilo y reservas de cada operación\n");
+    printf("  --perf                Contadores hardware por operación (ciclos, instrucciones, fallos LLC/dTLB)\n");
+    printf("  --trace RUTA          Guardar la línea de tiempo de operaciones e hilos (JSON para Perfetto)\n");
+    printf("  --help                Esta ayuda\n");
+    printf("Benchmarks: %s --bench [--sizes L] [--threads L] [--csv RUTA] [--json RUTA] ...\n", programa);
+    printf("Las operaciones puntuales consecutivas (brillo, contraste, gamma,\n");
+    printf("negativo, umbral) se fusionan en una sola pasada con tablas LUT.\n");
+}
+
+static int leerEnteroArg(const char* texto, int min, int max, int* valor) {
+    char* fin;
+    errno = 0;
+    long v = strtol(texto, &fin, 10);
+    if (errno != 0 || fin == texto || *fin != '\0' || v < min || v > max) return 0;
+    *valor = (int)v;
+    return 1;
+}
+
+static int leerFloatArg(const char* texto, float min, float max, float* valor) {
+    char* fin;
+    errno = 0;
+    float v = strtof(texto, &fin);
+    if (errno != 0 || fin == texto || *fin != '\0' || !(v >= min && v <= max)) return 0;
+    *valor = v;
+    return 1;
+}
+
+static int leerFiltroArg(const char* texto, FiltroResize* filtro) {
+    const char* nombres[] = {"auto", "bilinear", "area", "catmull", "mitchell", "lanczos"};
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(texto, nombres[i]) == 0) {
+            *filtro = (FiltroResize)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int leerFiltroPNGArg(const char* texto, int* filtro) {
+    if (strcmp(texto, "adaptive") == 0) {
+        *filtro = FILTRO_PNG_ADAPTATIVO;
+        return 1;
+    }
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(texto, nombresFiltroPNG[i]) == 0) {
+            *filtro = i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Convierte argv en un Pipeline. Devuelve 1 si es válido; en caso de error
+// informa del argumento problemático y devuelve 0.
+int analizarLineaComandos(int argc, char* argv[], Pipeline* p) {
+    memset(p, 0, sizeof(*p));
+    p->numHilos = MAX_HILOS_DEFAULT;
+    p->hilosES = 2;
+    p->png.nivel = NIVEL_PNG_DEFECTO;
+    p->png.filtro = FILTRO_PNG_ADAPTATIVO;
+    
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* valor = (i + 1 < argc) ? argv[i + 1] : NULL;
+        PasoPipeline paso;
+        memset(&paso, 0, sizeof(paso));
+        int ok = 1, consumeValor = 1, esPaso = 1;
+        
+        if (arg[0] != '-') {
+            if (p->entrada) {
+                fprintf(stderr, "❌ Error: Más de una imagen de entrada ('%s')\n", arg);
+                return 0;
+            }
+            p->entrada = arg;
+            continue;
+        }
+        
+        if (strcmp(arg, "--threads") == 0) {
+            esPaso = 0;
+            ok = valor && leerEnteroArg(valor, MIN_HILOS, MAX_HILOS, &p->numHilos);
+        } else if (strcmp(arg, "--batch") == 0) {
+            esPaso = 0;
+            ok = valor != NULL;
+            p->lote = valor;
+        } else if (strcmp(arg, "--out-dir") == 0) {
+            esPaso = 0;
+            ok = valor != NULL;
+            p->dirSalida = valor;
+        } else if (strcmp(arg, "--io-threads") == 0) {
+            esPaso = 0;
+            ok = valor && leerEnteroArg(valor, 1, MAX_HILOS_ES, &p->hilosES);
+        } else if (strcmp(arg, "--png-level") == 0) {
+            esPaso = 0;
+            ok = valor && leerEnteroArg(valor, 0, 9, &p->png.nivel);
+        } else if (strcmp(arg, "--png-filter") == 0) {
+            esPaso = 0;
+            ok = valor && leerFiltroPNGArg(valor, &p->png.filtro);
+        } else if (strcmp(arg, "--metrics") == 0) {
+            esPaso = 0;
+            ok = valor != NULL;
+            p->rutaMetricas = valor;
+        } else if (strcmp(arg, "--trace") == 0) {
+            esPaso = 0;
+            ok = valor != NULL;
+            p->rutaTraza = valor;
+        } else if (strcmp(arg, "--perf") == 0) {
+            esPaso = 0;
+            consumeValor = 0;
+            p->perfilHardware = 1;
+        } else if (strcmp(arg, "--keep-alpha") == 0) {
+            esPaso = 0;
+            consumeValor = 0;
+            p->conservarAlfa = 1;
+        } else if (strcmp(arg, "--brightness") == 0) {
+            paso.tipo = PASO_BRILLO;
+            ok = valor && leerEnteroArg(valor, -255, 255, &paso.entero1);
+        } else if (strcmp(arg, "--contrast") == 0) {
+            paso.tipo = PASO_CONTRASTE;
+            ok = valor && leerFloatArg(valor, 0.0f, 4.0f, &paso.real);
+        } else if (strcmp(arg, "--gamma") == 0) {
+            paso.tipo = PASO_GAMMA;
+            ok = valor && leerFloatArg(valor, 0.1f, 5.0f, &paso.real);
+        } else if (strcmp(arg, "--invert") == 0) {
+            paso.tipo = PASO_INVERTIR;
+            consumeValor = 0;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            paso.tipo = PASO_UMBRAL;
+            ok = valor && leerEnteroArg(valor, 0, 255, &paso.entero1);
+        } else if (strcmp(arg, "--blur") == 0) {
+            paso.tipo = PASO_DESENFOQUE;
+            ok = valor != NULL;
+            if (ok) {
+                char buf[64];
+                strncpy(buf, valor, sizeof(buf) - 1);
+                buf[sizeof(buf) - 1] = '\0';
+                char* sep = strchr(buf, ':');
+                if (sep) *sep = '\0';
+                ok = leerEnteroArg(buf, 3, 51, &paso.entero1) && paso.entero1 % 2 == 1;
+                paso.real = (float)paso.entero1 / 6.0f;
+                if (paso.real < 0.5f) paso.real = 0.5f;
+                if (ok && sep) ok = leerFloatArg(sep + 1, 0.1f, 50.0f, &paso.real);
+            }
+        } else if (strcmp(arg, "--fast-blur") == 0) {
+            paso.tipo = PASO_DESENFOQUE_RAPIDO;
+            ok = valor && leerFloatArg(valor, 0.5f, 50.0f, &paso.real);
+        } else if (strcmp(arg, "--rotate") == 0) {
+            paso.tipo = PASO_ROTAR;
+            ok = valor && leerFloatArg(valor, -360.0f, 360.0f, &paso.real);
+        } else if (strcmp(arg, "--flip") == 0) {
+            paso.tipo = PASO_VOLTEAR;
+            ok = valor && (strcmp(valor, "h") == 0 || strcmp(valor, "v") == 0 || strcmp(valor, "hv") == 0);
+            if (ok) {
+                paso.entero1 = strchr(valor, 'h') != NULL;
+                paso.entero2 = strchr(valor, 'v') != NULL;
+            }
+        } else if (strcmp(arg, "--sobel") == 0) {
+            paso.tipo = PASO_SOBEL;
+            consumeValor = 0;
+        } else if (strcmp(arg, "--resize") == 0) {
+            paso.tipo = PASO_REDIMENSIONAR;
+            paso.filtro = FILTRO_AUTO;
+            ok = valor != NULL;
+            if (ok) {
+                char buf[64], filtro[16] = "";
+                int n = 0;
+                ok = strlen(valor) < sizeof(buf) &&
+                     sscanf(valor, "%dx%d%n", &paso.entero1, &paso.entero2, &n) == 2 &&
+                     paso.entero1 >= 1 && paso.entero1 <= 10000 &&
+                     paso.entero2 >= 1 && paso.entero2 <= 10000;
+                if (ok && valor[n] != '\0') {
+                    ok = valor[n] == ':' && sscanf(valor + n + 1, "%15s", filtro) == 1 &&
+                         leerFiltroArg(filtro, &paso.filtro);
                 }
             }
+        } else if (strcmp(arg, "--save") == 0) {
+            paso.tipo = PASO_GUARDAR;
+            ok = valor != NULL;
+            paso.ruta = valor;
+        } else {
+            fprintf(stderr, "❌ Error: Opción desconocida '%s' (use --help)\n", arg);
+            return 0;
+        }
+        
+        if (!ok) {
+            fprintf(stderr, "❌ Error: Valor inválido o ausente para %s%s%s\n", arg,
+                    valor ? ": " : "", valor ? valor : "");
+            return 0;
+        }
+        if (consumeValor) i++;
+        
+        if (esPaso) {
+            if (p->numPasos >= MAX_PASOS) {
+                fprintf(stderr, "❌ Error: Demasiadas operaciones (máximo %d)\n", MAX_PASOS);
+                return 0;
+            }
+            p->pasos[p->numPasos++] = paso;
         }
     }
     
-    return NULL;
+    if (p->lote) {
+        if (p->entrada) {
+            fprintf(stderr, "❌ Error: Con --batch no se indica imagen de entrada ('%s')\n", p->entrada);
+            return 0;
+        }
+        if (!p->dirSalida) {
+            fprintf(stderr, "❌ Error: --batch requiere --out-dir\n");
+            return 0;
+        }
+        for (int i = 0; i < p->numPasos; i++) {
+            if (p->pasos[i].tipo == PASO_GUARDAR) {
+                fprintf(stderr, "❌ Error: --save no se admite con --batch (use --out-dir)\n");
+                return 0;
+            }
+        }
+        return 1;
+    }
+    
+    if (!p->entrada) {
+        fprintf(stderr, "❌ Error: Falta la imagen de entrada\n");
+        return 0;
+    }
+    return 1;
 }
 
-void rotarImagenConcurrente(ImagenInfo* info, float anguloGrados, int numHilos) {
-    if (!info || !info->pixeles) {
-        printf("❌ No hay imagen cargada\n");
-        return;
+static int esPasoPuntual(TipoPaso tipo) {
+    return tipo == PASO_BRILLO || tipo == PASO_CONTRASTE || tipo == PASO_GAMMA ||
+           tipo == PASO_INVERTIR || tipo == PASO_UMBRAL;
+}
+
+static void agregarPasoACadena(CadenaLUT* cadena, const PasoPipeline* paso) {
+    switch (paso->tipo) {
+        case PASO_BRILLO: cadenaBrillo(cadena, paso->entero1); break;
+        case PASO_CONTRASTE: cadenaContraste(cadena, paso->real); break;
+        case PASO_GAMMA: cadenaGamma(cadena, paso->real); break;
+        case PASO_INVERTIR: cadenaInvertir(cadena); break;
+        case PASO_UMBRAL: cadenaUmbral(cadena, paso->entero1); break;
+        default: break;
     }
-    
-    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
-    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
-    
-    printf("🔧 Rotando imagen %.2f° con %d hilos...\n", anguloGrados, numHilos);
-    
-    float ang = anguloGrados * (float)M_PI / 180.0f;
-    float cosA = cosf(ang), sinA = sinf(ang);
-    int w = info->ancho, h = info->alto;
-    float cx = (w - 1) / 2.0f, cy = (h - 1) / 2.0f;
-    
-    float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
-    float corners[4][2] = {{0, 0}, {(float)(w - 1), 0}, 
-                          {0, (float)(h - 1)}, {(float)(w - 1), (float)(h - 1)}};
-    
-    for (int i = 0; i < 4; i++) {
-        float x = corners[i][0], y = corners[i][1];
-        float rx = cosA * (x - cx) - sinA * (y - cy) + cx;
-        float ry = sinA * (x - cx) + cosA * (y - cy) + cy;
-        if (rx < minX) minX = rx;
-        if (rx > maxX) maxX = rx;
-        if (ry < minY) minY = ry;
-        if (ry > maxY) maxY = ry;
+}
+
+// Ejecuta el paso *i sobre la imagen y deja en descripcion un resumen para
+// el informe de tiempos. Las operaciones puntuales consecutivas se fusionan
+// en una CadenaLUT (una sola pasada) y *i avanza hasta la última de ellas;
+// un brillo aislado usa la ruta SIMD directa. Devuelve 0 si falla.
+static int aplicarPaso(ImagenInfo* imagen, const Pipeline* p, int* i, int numHilos,
+                       char* descripcion, size_t tamDescripcion) {
+    const PasoPipeline* paso = &p->pasos[*i];
+    int ok = 1;
+    
+    if (esPasoPuntual(paso->tipo)) {
+        int j = *i;
+        while (j + 1 < p->numPasos && esPasoPuntual(p->pasos[j + 1].tipo)) j++;
+        
+        if (j == *i && paso->tipo == PASO_BRILLO) {
+            ok = ajustarBrilloConcurrente(imagen, paso->entero1, numHilos);
+            snprintf(descripcion, tamDescripcion, "brillo %+d", paso->entero1);
+        } else {
+            CadenaLUT cadena;
+            iniciarCadenaLUT(&cadena);
+            for (int k = *i; k <= j; k++) agregarPasoACadena(&cadena, &p->pasos[k]);
+            ok = aplicarCadenaLUTConcurrente(imagen, &cadena, numHilos);
+            snprintf(descripcion, tamDescripcion, "cadena LUT (%d ops)", cadena.numOperaciones);
+        }
+        *i = j;
+        return ok;
     }
     
-    int anchoDestino = (int)floorf(maxX - minX) + 1;
-    int altoDestino = (int)floorf(maxY - minY) + 1;
-    
-    if (anchoDestino <= 0) anchoDestino = 1;
-    if (altoDestino <= 0) altoDestino = 1;
+    switch (paso->tipo) {
+        case PASO_DESENFOQUE:
+            ok = aplicarConvolucionConcurrente(imagen, paso->entero1, paso->real, numHilos);
+            snprintf(descripcion, tamDescripcion, "desenfoque %dx%d", paso->entero1, paso->entero1);
+            break;
+        case PASO_DESENFOQUE_RAPIDO:
+            ok = aplicarDesenfoqueRapidoConcurrente(imagen, paso->real, numHilos);
+            snprintf(descripcion, tamDescripcion, "desenfoque rápido σ=%.2f", paso->real);
+            break;
+        case PASO_ROTAR:
+            ok = rotarImagenConcurrente(imagen, paso->real, numHilos);
+            snprintf(descripcion, tamDescripcion, "rotar %.2f°", paso->real);
+            break;
+        case PASO_VOLTEAR:
+            ok = voltearImagenConcurrente(imagen, paso->entero1, paso->entero2, numHilos);
+            snprintf(descripcion, tamDescripcion, "voltear");
+            break;
+        case PASO_SOBEL:
+            ok = detectarBordesSobelConcurrente(imagen, numHilos);
+            snprintf(descripcion, tamDescripcion, "sobel");
+            break;
+        case PASO_REDIMENSIONAR:
+            ok = redimensionarConcurrente(imagen, paso->entero1, paso->entero2, numHilos, paso->filtro);
+            snprintf(descripcion, tamDescripcion, "redimensionar %dx%d", paso->entero1, paso->entero2);
+            break;
+        case PASO_GUARDAR:
+            ok = guardarPNG(imagen, paso->ruta, &p->png, numHilos);
+            snprintf(descripcion, tamDescripcion, "guardar");
+            break;
+        default:
+            break;
+    }
+    return ok;
+}
+
+// aplicarPaso registrando sus métricas en el historial con la descripción
+// como nombre.
+int ejecutarPaso(ImagenInfo* imagen, const Pipeline* p, int* i, int numHilos,
+                 char* descripcion, size_t tamDescripcion) {
+    // Nombre provisional (visible en la traza mientras se ejecuta); al
+    // terminar se sustituye por la descripción completa.
+    MetricasOperacion m;
+    iniciarMetricas(&m, nombresPaso[p->pasos[*i].tipo], numHilos, imagen);
+    int ok = aplicarPaso(imagen, p, i, numHilos, descripcion, tamDescripcion);
+    snprintf(m.nombre, sizeof(m.nombre), "%s", descripcion);
+    finalizarMetricas(&m, imagen);
+    return ok;
+}
+
+// Ejecuta los pasos en orden sin ninguna pregunta, mostrando el tiempo de
+// cada uno. Devuelve EXIT_SUCCESS o EXIT_FAILURE.
+int ejecutarPipeline(const Pipeline* p) {
+    ImagenInfo imagen = {0, 0, 0, 0, NULL};
+    int numHilos = p->numHilos;
+    int resultado = EXIT_SUCCESS;
+    double inicioTotal = tiempoActual();
+    
+    MetricasOperacion carga;
+    iniciarMetricas(&carga, "cargar", 1, NULL);
+    int cargada = cargarImagen(p->entrada, &imagen, p->conservarAlfa);
+    finalizarMetricas(&carga, &imagen);
+    if (!cargada) return EXIT_FAILURE;
+    printf("⏱  cargar: %.2f ms (reserva %.2f ms)\n", carga.tiempoPared * 1e3, carga.tiempoReserva * 1e3);
+    
+    int guardados = 0;
+    for (int i = 0; i < p->numPasos && resultado == EXIT_SUCCESS; i++) {
+        char descripcion[64];
+        if (p->pasos[i].tipo == PASO_GUARDAR) guardados++;
+        if (!ejecutarPaso(&imagen, p, &i, numHilos, descripcion, sizeof(descripcion))) {
+            resultado = EXIT_FAILURE;
+        }
+        const MetricasOperacion* m = ultimaMetrica();
+        printf("⏱  %s: %.2f ms (%d hilos, desbalance %.2f, utilización %.0f%%, reserva %.2f ms)\n",
+               descripcion, m->tiempoPared * 1e3, m->hilosUsados, desbalanceMetricas(m),
+               utilizacionMetricas(m) * 100.0, m->tiempoReserva * 1e3);
+        if (m->perfilHardware) {
+            char contadores[128];
+            describirContadores(m, contadores, sizeof(contadores));
+            printf("   🔬 %s\n", contadores);
+        }
+    }
     
-    printf("   Nueva dimensión: %dx%d píxeles\n", anchoDestino, altoDestino);
+    if (guardados == 0 && resultado == EXIT_SUCCESS) {
+        printf("⚠ Ningún --save en la línea de comandos: el resultado no se ha guardado\n");
+    }
+    printf("%s Pipeline %s en %.2f ms (%d hilos)\n",
+           resultado == EXIT_SUCCESS ? "✅" : "❌",
+           resultado == EXIT_SUCCESS ? "completado" : "interrumpido",
+           (tiempoActual() - inicioTotal) * 1e3, numHilos);
     
-    unsigned char*** dst = crearMatrizPixeles(altoDestino, anchoDestino, info->canales);
-    if (!dst) {
-        fprintf(stderr, "❌ Error: No se pudo crear matriz destino para rotación\n");
-        return;
+    liberarImagen(&imagen);
+    return resultado;
+}
+
+// ============================================================================
+// PROCESAMIENTO POR LOTES (ETAPAS ENCADENADAS)
+// ============================================================================
+
+#define CAPACIDAD_COLA_LOTE 2
+
+// Cola acotada productor/consumidor: encolar bloquea si está llena y
+// desencolar si está vacía; tras cerrarla, desencolar devuelve NULL cuando
+// ya no quedan elementos.
+typedef struct {
+    void* elementos[CAPACIDAD_COLA_LOTE];
+    int inicio, cantidad;
+    int cerrada;
+    pthread_mutex_t mutex;
+    pthread_cond_t noVacia;
+    pthread_cond_t noLlena;
+} ColaAcotada;
+
+void iniciarCola(ColaAcotada* c) {
+    c->inicio = 0;
+    c->cantidad = 0;
+    c->cerrada = 0;
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->noVacia, NULL);
+    pthread_cond_init(&c->noLlena, NULL);
+}
+
+void destruirCola(ColaAcotada* c) {
+    pthread_mutex_destroy(&c->mutex);
+    pthread_cond_destroy(&c->noVacia);
+    pthread_cond_destroy(&c->noLlena);
+}
+
+void encolar(ColaAcotada* c, void* elemento) {
+    pthread_mutex_lock(&c->mutex);
+    while (c->cantidad == CAPACIDAD_COLA_LOTE) {
+        pthread_cond_wait(&c->noLlena, &c->mutex);
+    }
+    c->elementos[(c->inicio + c->cantidad) % CAPACIDAD_COLA_LOTE] = elemento;
+    c->cantidad++;
+    pthread_cond_signal(&c->noVacia);
+    pthread_mutex_unlock(&c->mutex);
+}
+
+void* desencolar(ColaAcotada* c) {
+    pthread_mutex_lock(&c->mutex);
+    while (c->cantidad == 0 && !c->cerrada) {
+        pthread_cond_wait(&c->noVacia, &c->mutex);
+    }
+    void* elemento = NULL;
+    if (c->cantidad > 0) {
+        elemento = c->elementos[c->inicio];
+        c->inicio = (c->inicio + 1) % CAPACIDAD_COLA_LOTE;
+        c->cantidad--;
+        pthread_cond_signal(&c->noLlena);
+    }
+    pthread_mutex_unlock(&c->mutex);
+    return elemento;
+}
+
+void cerrarCola(ColaAcotada* c) {
+    pthread_mutex_lock(&c->mutex);
+    c->cerrada = 1;
+    pthread_cond_broadcast(&c->noVacia);
+    pthread_mutex_unlock(&c->mutex);
+}
+
+// Imagen en tránsito entre etapas
+typedef struct {
+    int indice;
+    int ok;
+    ImagenInfo imagen;
+    double tDecodificar, tFiltrar, tCodificar;
+} ElementoLote;
+
+typedef struct {
+    const Pipeline* pipeline;
+    char** rutas;
+    char** salidas;                 // ruta de salida de cada entrada
+    int numRutas;
+    atomic_int siguiente;           // próxima ruta a decodificar
+    atomic_int decodificadoresVivos;
+    ColaAcotada decodificadas;
+    ColaAcotada filtradas;
+    atomic_int errores;
+    double tDecodificar, tFiltrar, tCodificar;  // sumas, protegidas por mutex
+    double megapixeles;
+    pthread_mutex_t mutex;
+} Lote;
+
+static int esExtensionImagen(const char* nombre) {
+    const char* ext[] = {".png", ".jpg", ".jpeg", ".bmp", ".tga", ".gif", ".psd", ".hdr", ".pgm", ".ppm", ".pnm"};
+    const char* punto = strrchr(nombre, '.');
+    if (!punto) return 0;
+    for (size_t i = 0; i < sizeof(ext) / sizeof(ext[0]); i++) {
+        if (strcasecmp(punto, ext[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int compararRutas(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static int agregarRuta(char*** rutas, int* num, int* capacidad, const char* ruta) {
+    if (*num == *capacidad) {
+        int nueva = *capacidad ? *capacidad * 2 : 64;
+        char** r = (char**)realloc(*rutas, (size_t)nueva * sizeof(char*));
+        if (!r) return 0;
+        *rutas = r;
+        *capacidad = nueva;
+    }
+    char* copia = strdup(ruta);
+    if (!copia) return 0;
+    (*rutas)[(*num)++] = copia;
+    return 1;
+}
+
+// Obtiene las rutas del lote: si 'origen' es un directorio se toman sus
+// imágenes (ordenadas por nombre); si es un archivo, se lee como lista con
+// una ruta por línea. Devuelve el número de rutas, o -1 si hay error.
+int listarEntradasLote(const char* origen, char*** rutas) {
+    int num = 0, capacidad = 0;
+    struct stat st;
+    *rutas = NULL;
+    
+    if (stat(origen, &st) != 0) {
+        fprintf(stderr, "❌ Error: No se puede acceder a '%s': %s\n", origen, strerror(errno));
+        return -1;
     }
     
-    if (numHilos > altoDestino) numHilos = altoDestino;
+    if (S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(origen);
+        if (!dir) {
+            fprintf(stderr, "❌ Error: No se pudo abrir el directorio '%s'\n", origen);
+            return -1;
+        }
+        struct dirent* e;
+        char ruta[BUFFER_SIZE];
+        while ((e = readdir(dir)) != NULL) {
+            if (e->d_name[0] == '.' || !esExtensionImagen(e->d_name)) continue;
+            snprintf(ruta, sizeof(ruta), "%s/%s", origen, e->d_name);
+            if (!agregarRuta(rutas, &num, &capacidad, ruta)) break;
+        }
+        closedir(dir);
+        if (num > 1) qsort(*rutas, (size_t)num, sizeof(char*), compararRutas);
+    } else {
+        FILE* f = fopen(origen, "r");
+        if (!f) {
+            fprintf(stderr, "❌ Error: No se pudo abrir la lista '%s'\n", origen);
+            return -1;
+        }
+        char linea[BUFFER_SIZE];
+        while (fgets(linea, sizeof(linea), f)) {
+            linea[strcspn(linea, "\r\n")] = '\0';
+            if (linea[0] == '\0' || linea[0] == '#') continue;
+            if (!agregarRuta(rutas, &num, &capacidad, linea)) break;
+        }
+        fclose(f);
+    }
     
-    pthread_t* hilos = malloc(sizeof(pthread_t) * (size_t)numHilos);
-    RotArgs* args = malloc(sizeof(RotArgs) * (size_t)numHilos);
+    return num;
+}
+
+static const char* nombreBaseLote(const char* ruta) {
+    const char* base = strrchr(ruta, '/');
+    return base ? base + 1 : ruta;
+}
+
+// Ruta de salida: directorio de salida + nombre base + ".png". Con
+// conservarExtension el nombre base mantiene su extensión (foto.jpg.png).
+static void rutaSalidaLote(const char* dirSalida, const char* entrada, int conservarExtension,
+                           char* salida, size_t tam) {
+    const char* base = nombreBaseLote(entrada);
+    const char* punto = conservarExtension ? NULL : strrchr(base, '.');
+    int largo = punto ? (int)(punto - base) : (int)strlen(base);
+    snprintf(salida, tam, "%s/%.*s.png", dirSalida, largo, base);
+}
+
+typedef struct {
+    const char* ruta;
+    int indice;
+} RutaIndexada;
+
+static int compararRutaIndexada(const void* a, const void* b) {
+    const RutaIndexada* x = (const RutaIndexada*)a;
+    const RutaIndexada* y = (const RutaIndexada*)b;
+    int c = strcmp(x->ruta, y->ruta);
+    return c ? c : (x->indice > y->indice) - (x->indice < y->indice);
+}
+
+// Calcula la ruta de salida de cada entrada antes de empezar. Las entradas
+// cuyo nombre coincidiría (foto.png y foto.jpg) conservan su extensión; si
+// aun así dos entradas van al mismo archivo (a/x.png y b/x.png), o una
+// salida es su propia entrada, el lote no se ejecuta. Devuelve 1 si las
+// salidas son válidas.
+static int prepararSalidasLote(const char* dirSalida, char** rutas, int num, char*** salidas) {
+    char ruta[BUFFER_SIZE];
+    int ok = 1;
+    *salidas = (char**)calloc((size_t)num, sizeof(char*));
+    RutaIndexada* orden = (RutaIndexada*)malloc((size_t)num * sizeof(RutaIndexada));
+    if (!*salidas || !orden) {
+        fprintf(stderr, "❌ Error: Memoria insuficiente para las rutas de salida\n");
+        free(orden);
+        return 0;
+    }
     
-    if (!hilos || !args) {
-        fprintf(stderr, "❌ Error: Memoria insuficiente para hilos\n");
-        free(hilos);
-        free(args);
-        freeMatriz(dst, altoDestino, anchoDestino);
-        return;
+    for (int i = 0; i < num && ok; i++) {
+        rutaSalidaLote(dirSalida, rutas[i], 0, ruta, sizeof(ruta));
+        ok = ((*salidas)[i] = strdup(ruta)) != NULL;
     }
     
-    int filas = (altoDestino + numHilos - 1) / numHilos;
-    int hilosCreados = 0;
-    
-    for (int i = 0; i < numHilos; i++) {
-        args[i].pixelesOrigen = info->pixeles;
-        args[i].pixelesDestino = dst;
-        args[i].inicio = i * filas;
-        args[i].fin = ((i + 1) * filas < altoDestino) ? (i + 1) * filas : altoDestino;
-        args[i].anchoOrigen = info->ancho;
-        args[i].altoOrigen = info->alto;
-        args[i].canales = info->canales;
-        args[i].anchoDestino = anchoDestino;
-        args[i].altoDestino = altoDestino;
-        args[i].cosA = cosA;
-        args[i].sinA = sinA;
-        args[i].minX = minX;
-        args[i].minY = minY;
-        args[i].cx = cx;
-        args[i].cy = cy;
-        args[i].hiloId = i;
-        
-        if (args[i].inicio < args[i].fin) {
-            if (pthread_create(&hilos[i], NULL, rotarWorker, &args[i]) != 0) {
-                fprintf(stderr, "⚠ Advertencia: No se pudo crear hilo %d\n", i);
-                args[i].inicio = args[i].fin;
-            } else {
-                hilosCreados++;
+    for (int pasada = 0; pasada < 2 && ok; pasada++) {
+        for (int i = 0; i < num; i++) {
+            orden[i].ruta = (*salidas)[i];
+            orden[i].indice = i;
+        }
+        qsort(orden, (size_t)num, sizeof(RutaIndexada), compararRutaIndexada);
+        
+        for (int i = 0; i + 1 < num && ok; i++) {
+            if (strcmp(orden[i].ruta, orden[i + 1].ruta) != 0) continue;
+            
+            int a = orden[i].indice, b = orden[i + 1].indice;
+            if (pasada == 1) {
+                fprintf(stderr, "❌ Error: '%s' y '%s' se guardarían en el mismo archivo '%s'\n",
+                        rutas[a], rutas[b], orden[i].ruta);
+                ok = 0;
+                break;
+            }
+            
+            // Todo el grupo con el mismo nombre pasa a conservar la extensión
+            int fin = i + 1;
+            while (fin + 1 < num && strcmp(orden[fin + 1].ruta, orden[i].ruta) == 0) fin++;
+            for (int k = i; k <= fin && ok; k++) {
+                int j = orden[k].indice;
+                rutaSalidaLote(dirSalida, rutas[j], 1, ruta, sizeof(ruta));
+                char* nueva = strdup(ruta);
+                if (!nueva) {
+                    ok = 0;
+                    break;
+                }
+                printf("⚠ Nombre de salida repetido: %s → %s\n", rutas[j], nueva);
+                free((*salidas)[j]);
+                (*salidas)[j] = nueva;
             }
+            // Los punteros de 'orden' del grupo ya no son válidos; se salta
+            i = fin;
         }
     }
-    
-    for (int i = 0; i < numHilos; i++) {
-        if (args[i].inicio < args[i].fin) {
-            pthread_join(hilos[i], NULL);
+    free(orden);
+    
+    // Una salida que resuelve al mismo archivo que su entrada la sobrescribiría
+    char* dirReal = ok ? realpath(dirSalida, NULL) : NULL;
+    for (int i = 0; i < num && ok && dirReal; i++) {
+        char* entradaReal = realpath(rutas[i], NULL);
+        if (!entradaReal) continue;
+        const char* base = strrchr((*salidas)[i], '/');
+        snprintf(ruta, sizeof(ruta), "%s%s", dirReal, base ? base : "/");
+        if (strcmp(ruta, entradaReal) == 0) {
+            fprintf(stderr, "❌ Error: '%s' se sobrescribiría a sí misma; use otro --out-dir\n", rutas[i]);
+            ok = 0;
         }
+        free(entradaReal);
     }
+    free(dirReal);
     
-    int canales_originales = info->canales;
+    if (!ok) {
+        for (int i = 0; i < num; i++) free((*salidas)[i]);
+        free(*salidas);
+        *salidas = NULL;
+    }
+    return ok;
+}
+
+static void* etapaDecodificar(void* arg) {
+    Lote* lote = (Lote*)arg;
+    nombrarHiloTraza("decodificador");
     
-    liberarImagen(info);
-    info->ancho = anchoDestino;
-    info->alto = altoDestino;
-    info->canales = canales_originales;
-    info->pixeles = dst;
+    for (;;) {
+        int i = atomic_fetch_add(&lote->siguiente, 1);
+        if (i >= lote->numRutas) break;
+        
+        ElementoLote* e = (ElementoLote*)calloc(1, sizeof(ElementoLote));
+        if (!e) {
+            atomic_fetch_add(&lote->errores, 1);
+            continue;
+        }
+        e->indice = i;
+        MetricasOperacion m;
+        char nombre[64];
+        snprintf(nombre, sizeof(nombre), "cargar %s", nombreBaseLote(lote->rutas[i]));
+        iniciarMetricas(&m, nombre, 1, NULL);
+        e->ok = cargarImagen(lote->rutas[i], &e->imagen, lote->pipeline->conservarAlfa);
+        finalizarMetricas(&m, &e->imagen);
+        e->tDecodificar = m.tiempoPared;
+        if (!e->ok) atomic_fetch_add(&lote->errores, 1);
+        encolar(&lote->decodificadas, e);
+    }
     
-    free(hilos);
-    free(args);
-    printf("✓ Rotación completada (%d hilos utilizados)\n", hilosCreados);
+    // El último decodificador en salir cierra la cola
+    if (atomic_fetch_sub(&lote->decodificadoresVivos, 1) == 1) {
+        cerrarCola(&lote->decodificadas);
+    }
+    return NULL;
 }
 
-// ============================================================================
-// DETECCIÓN DE BORDES SOBEL
-// ============================================================================
-
-typedef struct {
-    unsigned char*** src;
-    unsigned char*** dst;
-    int inicio, fin, ancho, alto, canales;
-    int hiloId;
-} SobelArgs;
-
-void* sobelWorker(void* arg) {
-    SobelArgs* s = (SobelArgs*)arg;
-    int gx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
-    int gy[3][3] = {{1, 2, 1}, {0, 0, 0}, {-1, -2, -1}};
-    
-    for (int y = s->inicio; y < s->fin; y++) {
-        for (int x = 0; x < s->ancho; x++) {
-            float sumx = 0.0f, sumy = 0.0f;
-            
-            for (int ky = -1; ky <= 1; ky++) {
-                for (int kx = -1; kx <= 1; kx++) {
-                    int yy = y + ky;
-                    int xx = x + kx;
-                    
-                    if (yy < 0) yy = 0;
-                    if (yy >= s->alto) yy = s->alto - 1;
-                    if (xx < 0) xx = 0;
-                    if (xx >= s->ancho) xx = s->ancho - 1;
-                    
-                    float valc;
-                    if (s->canales >= 3) {
-                        float r = (float)s->src[yy][xx][0];
-                        float g = (float)s->src[yy][xx][1];
-                        float b = (float)s->src[yy][xx][2];
-                        valc = 0.299f * r + 0.587f * g + 0.114f * b;
-                    } else {
-                        valc = (float)s->src[yy][xx][0];
-                    }
-                    
-                    float gx_val = (float)gx[ky + 1][kx + 1];
-                    float gy_val = (float)gy[ky + 1][kx + 1];
-                    
-                    sumx += gx_val * valc;
-                    sumy += gy_val * valc;
-                }
+static void* etapaCodificar(void* arg) {
+    Lote* lote = (Lote*)arg;
+    nombrarHiloTraza("codificador");
+    ElementoLote* e;
+    
+    while ((e = (ElementoLote*)desencolar(&lote->filtradas)) != NULL) {
+        if (e->ok) {
+            MetricasOperacion m;
+            char nombre[64];
+            snprintf(nombre, sizeof(nombre), "guardar %s", nombreBaseLote(lote->salidas[e->indice]));
+            iniciarMetricas(&m, nombre, lote->pipeline->numHilos, &e->imagen);
+            if (!guardarPNG(&e->imagen, lote->salidas[e->indice], &lote->pipeline->png, lote->pipeline->numHilos)) {
+                atomic_fetch_add(&lote->errores, 1);
             }
+            finalizarMetricas(&m, &e->imagen);
+            e->tCodificar = m.tiempoPared;
             
-            float magnitude = sqrtf(sumx * sumx + sumy * sumy);
-            s->dst[y][x][0] = clampuc((int)roundf(magnitude));
+            pthread_mutex_lock(&lote->mutex);
+            lote->tDecodificar += e->tDecodificar;
+            lote->tFiltrar += e->tFiltrar;
+            lote->tCodificar += e->tCodificar;
+            lote->megapixeles += (double)e->imagen.ancho * e->imagen.alto / 1e6;
+            pthread_mutex_unlock(&lote->mutex);
         }
+        liberarImagen(&e->imagen);
+        free(e);
     }
-    
     return NULL;
 }
 
-void detectarBordesSobelConcurrente(ImagenInfo* info, int numHilos) {
-    if (!info || !info->pixeles) {
-        printf("❌ No hay imagen cargada\n");
-        return;
+// Procesa todas las imágenes del lote en tres etapas encadenadas por colas
+// acotadas: decodificación (hilosES hilos), cadena de filtros (este hilo,
+// que reparte cada operación en el pool) y codificación PNG (hilosES
+// hilos). Así la decodificación de la imagen N+1 y la codificación de la
+// N-1 se solapan con el filtrado de la N, y como mucho hay unas pocas
+// imágenes en memoria a la vez. Devuelve EXIT_SUCCESS o EXIT_FAILURE.
+int ejecutarLote(const Pipeline* p) {
+    Lote lote;
+    memset(&lote, 0, sizeof(lote));
+    lote.pipeline = p;
+    lote.numRutas = listarEntradasLote(p->lote, &lote.rutas);
+    if (lote.numRutas < 0) return EXIT_FAILURE;
+    if (lote.numRutas == 0) {
+        fprintf(stderr, "❌ Error: No hay imágenes en '%s'\n", p->lote);
+        return EXIT_FAILURE;
     }
     
-    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
-    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
-    
-    int ancho = info->ancho, alto = info->alto;
-    
-    printf("🔧 Detectando bordes (Sobel) con %d hilos...\n", numHilos);
-    printf("   Imagen de entrada: %dx%d, %d canales\n", ancho, alto, info->canales);
-    
-    unsigned char*** dst = crearMatrizPixeles(alto, ancho, 1);
-    if (!dst) {
-        fprintf(stderr, "❌ Error: No se pudo crear matriz destino para Sobel\n");
-        return;
+    int dirCreado = mkdir(p->dirSalida, 0755) == 0 || errno == EEXIST;
+    if (!dirCreado) {
+        fprintf(stderr, "❌ Error: No se pudo crear '%s': %s\n", p->dirSalida, strerror(errno));
     }
-    
-    if (numHilos > alto) numHilos = alto;
-    
-    pthread_t* hilos = malloc(sizeof(pthread_t) * (size_t)numHilos);
-    SobelArgs* args = malloc(sizeof(SobelArgs) * (size_t)numHilos);
-    
-    if (!hilos || !args) {
-        fprintf(stderr, "❌ Error: Memoria insuficiente para hilos\n");
-        free(hilos);
-        free(args);
-        freeMatriz(dst, alto, ancho);
-        return;
+    if (!dirCreado || !prepararSalidasLote(p->dirSalida, lote.rutas, lote.numRutas, &lote.salidas)) {
+        for (int i = 0; i < lote.numRutas; i++) free(lote.rutas[i]);
+        free(lote.rutas);
+        return EXIT_FAILURE;
     }
     
-    int filas = (alto + numHilos - 1) / numHilos;
-    int hilosCreados = 0;
-    
-    for (int i = 0; i < numHilos; i++) {
-        args[i].src = info->pixeles;
-        args[i].dst = dst;
-        args[i].inicio = i * filas;
-        args[i].fin = ((i + 1) * filas < alto) ? (i + 1) * filas : alto;
-        args[i].ancho = ancho;
-        args[i].alto = alto;
-        args[i].canales = info->canales;
-        args[i].hiloId = i;
-        
-        if (args[i].inicio < args[i].fin) {
-            if (pthread_create(&hilos[i], NULL, sobelWorker, &args[i]) != 0) {
-                fprintf(stderr, "⚠ Advertencia: No se pudo crear hilo %d\n", i);
-                args[i].inicio = args[i].fin;
-            } else {
-                hilosCreados++;
-            }
+    int hilosES = p->hilosES;
+    printf("📦 Lote de %d imágenes → %s (%d hilos de filtrado, %d decodificadores, %d codificadores)\n",
+           lote.numRutas, p->dirSalida, p->numHilos, hilosES, hilosES);
+    
+    atomic_init(&lote.siguiente, 0);
+    atomic_init(&lote.decodificadoresVivos, hilosES);
+    atomic_init(&lote.errores, 0);
+    iniciarCola(&lote.decodificadas);
+    iniciarCola(&lote.filtradas);
+    pthread_mutex_init(&lote.mutex, NULL);
+    
+    double inicio = tiempoActual();
+    pthread_t decodificadores[MAX_HILOS_ES], codificadores[MAX_HILOS_ES];
+    int numDec = 0, numCod = 0;
+    for (int i = 0; i < hilosES; i++) {
+        if (pthread_create(&codificadores[numCod], NULL, etapaCodificar, &lote) == 0) numCod++;
+    }
+    if (numCod == 0) {
+        fprintf(stderr, "❌ Error: No se pudieron crear los hilos de codificación\n");
+        atomic_store(&lote.decodificadoresVivos, 0);
+        cerrarCola(&lote.decodificadas);
+        atomic_store(&lote.errores, lote.numRutas);
+    } else {
+        for (int i = 0; i < hilosES; i++) {
+            if (pthread_create(&decodificadores[numDec], NULL, etapaDecodificar, &lote) == 0) numDec++;
+        }
+        // Los decodificadores que no arrancaron cuentan como ya terminados
+        int faltan = hilosES - numDec;
+        if (faltan > 0 && atomic_fetch_sub(&lote.decodificadoresVivos, faltan) == faltan) {
+            cerrarCola(&lote.decodificadas);
+        }
+        if (numDec == 0) {
+            fprintf(stderr, "❌ Error: No se pudieron crear los hilos de decodificación\n");
+            atomic_store(&lote.errores, lote.numRutas);
         }
     }
     
-    for (int i = 0; i < numHilos; i++) {
-        if (args[i].inicio < args[i].fin) {
-            pthread_join(hilos[i], NULL);
+    // Etapa de filtrado en este hilo
+    ElementoLote* e;
+    while ((e = (ElementoLote*)desencolar(&lote.decodificadas)) != NULL) {
+        if (e->ok) {
+            double t0 = tiempoActual();
+            char descripcion[64];
+            for (int i = 0; i < p->numPasos && e->ok; i++) {
+                if (!ejecutarPaso(&e->imagen, p, &i, p->numHilos, descripcion, sizeof(descripcion))) {
+                    fprintf(stderr, "❌ Error: '%s' falló en %s; no se guardará\n",
+                            lote.rutas[e->indice], descripcion);
+                    e->ok = 0;
+                    atomic_fetch_add(&lote.errores, 1);
+                }
+            }
+            e->tFiltrar = tiempoActual() - t0;
         }
+        encolar(&lote.filtradas, e);
     }
+    cerrarCola(&lote.filtradas);
+    
+    for (int i = 0; i < numDec; i++) pthread_join(decodificadores[i], NULL);
+    for (int i = 0; i < numCod; i++) pthread_join(codificadores[i], NULL);
+    double total = tiempoActual() - inicio;
+    
+    int errores = atomic_load(&lote.errores);
+    int procesadas = lote.numRutas - errores;
+    printf("\n📊 RESUMEN DEL LOTE\n");
+    printf("────────────────────────────────────────────────────────\n");
+    printf("   Imágenes: %d procesadas, %d con error\n", procesadas, errores);
+    printf("   Tiempo total: %.2f s (%.2f imágenes/s, %.1f MP/s de salida)\n",
+           total, procesadas / total, lote.megapixeles / total);
+    printf("   Suma por etapa: decodificar %.2f s, filtrar %.2f s, codificar %.2f s\n",
+           lote.tDecodificar, lote.tFiltrar, lote.tCodificar);
+    printf("   Solapamiento: %.2fx (suma de etapas / tiempo total)\n",
+           (lote.tDecodificar + lote.tFiltrar + lote.tCodificar) / total);
+    
+    destruirCola(&lote.decodificadas);
+    destruirCola(&lote.filtradas);
+    pthread_mutex_destroy(&lote.mutex);
+    for (int i = 0; i < lote.numRutas; i++) {
+        free(lote.rutas[i]);
+        free(lote.salidas[i]);
+    }
+    free(lote.rutas);
+    free(lote.salidas);
     
-    int ancho_orig = info->ancho;
-    int alto_orig = info->alto;
-    
-    liberarImagen(info);
-    info->pixeles = dst;
-    info->ancho = ancho_orig;
-    info->alto = alto_orig;
-    info->canales = 1;
-    
-    free(hilos);
-    free(args);
-    printf("✓ Detección de bordes completada (%d hilos utilizados)\n", hilosCreados);
-    printf("   Imagen de salida: escala de grises (1 canal)\n");
+    return errores == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 // ============================================================================
-// REDIMENSIONAR
+// SUITE DE BENCHMARKS (--bench)
 // ============================================================================
 
+#define BENCH_MAX_LISTA 32
+
+typedef enum {
+    BENCH_BRILLO,
+    BENCH_CONVOLUCION,
+    BENCH_ROTAR,
+    BENCH_SOBEL,
+    BENCH_RESIZE,
+    BENCH_CARGAR,
+    BENCH_GUARDAR
+} OperacionBench;
+
 typedef struct {
-    unsigned char*** src;
-    unsigned char*** dst;
-    int inicio, fin, anchoSrc, altoSrc, anchoDst, altoDst, canales;
-    float scaleX, scaleY;
-    int hiloId;
-} ResizeArgs;
+    OperacionBench op;
+    const char* nombre;
+    int parametro;              // delta, kernel, grados o porcentaje según op
+    FiltroResize filtro;        // solo BENCH_RESIZE
+} CasoBench;
 
-void* resizeWorker(void* arg) {
-    ResizeArgs* r = (ResizeArgs*)arg;
-    unsigned char out_local[4];
-    
-    for (int y = r->inicio; y < r->fin; y++) {
-        for (int x = 0; x < r->anchoDst; x++) {
-            float fx = (x + 0.5f) * r->scaleX - 0.5f;
-            float fy = (y + 0.5f) * r->scaleY - 0.5f;
-            
-            sampleBilinear(r->src, r->anchoSrc, r->altoSrc, r->canales, fx, fy, out_local);
-            
-            for (int c = 0; c < r->canales; c++) {
-                r->dst[y][x][c] = out_local[c];
-            }
+typedef struct {
+    double tamanosMP[BENCH_MAX_LISTA];
+    int numTamanos;
+    int canales[BENCH_MAX_LISTA];
+    int numCanales;
+    int hilos[BENCH_MAX_LISTA];
+    int numHilos;
+    int kernels[BENCH_MAX_LISTA];
+    int numKernels;
+    int repeticiones;
+    const char* rutaCSV;
+    const char* rutaJSON;
+} OpcionesBench;
+
+typedef struct {
+    const char* operacion;
+    int parametro;
+    int ancho, alto, canales, hilos;
+    double mediana, p95;        // segundos
+    double mpPorSegundo;
+    double eficiencia;          // respecto al menor número de hilos medido
+} ResultadoBench;
+
+// Los *Concurrente informan de cada llamada por stdout; mientras se mide
+// se redirige a /dev/null para no cronometrar la terminal. Devuelve el
+// descriptor original (o -1 si no se pudo redirigir).
+static int silenciarStdout(void) {
+    fflush(stdout);
+    int copia = dup(STDOUT_FILENO);
+    int nulo = open("/dev/null", O_WRONLY);
+    if (copia < 0 || nulo < 0 || dup2(nulo, STDOUT_FILENO) < 0) {
+        if (copia >= 0) close(copia);
+        if (nulo >= 0) close(nulo);
+        return -1;
+    }
+    close(nulo);
+    return copia;
+}
+
+static void restaurarStdout(int copia) {
+    if (copia < 0) return;
+    fflush(stdout);
+    dup2(copia, STDOUT_FILENO);
+    close(copia);
+}
+
+static int compararDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Lista separada por comas; cada elemento puede ser un rango "a-b".
+static int leerListaEnteros(const char* texto, int min, int max, int* lista, int* num) {
+    char copia[BUFFER_SIZE];
+    snprintf(copia, sizeof(copia), "%s", texto);
+    *num = 0;
+    for (char* tok = strtok(copia, ","); tok; tok = strtok(NULL, ",")) {
+        int desde, hasta;
+        char* guion = strchr(tok + 1, '-');
+        if (guion) {
+            *guion = '\0';
+            if (!leerEnteroArg(tok, min, max, &desde) || !leerEnteroArg(guion + 1, min, max, &hasta)) return 0;
+        } else {
+            if (!leerEnteroArg(tok, min, max, &desde)) return 0;
+            hasta = desde;
+        }
+        for (int v = desde; v <= hasta; v++) {
+            if (*num >= BENCH_MAX_LISTA) return 0;
+            lista[(*num)++] = v;
         }
     }
-    
-    return NULL;
+    return *num > 0;
 }
 
-void redimensionarConcurrente(ImagenInfo* info, int nuevoAncho, int nuevoAlto, int numHilos) {
-    if (!info || !info->pixeles) {
-        printf("❌ No hay imagen cargada\n");
-        return;
+static int leerListaReales(const char* texto, float min, float max, double* lista, int* num) {
+    char copia[BUFFER_SIZE];
+    snprintf(copia, sizeof(copia), "%s", texto);
+    *num = 0;
+    for (char* tok = strtok(copia, ","); tok; tok = strtok(NULL, ",")) {
+        float v;
+        if (*num >= BENCH_MAX_LISTA || !leerFloatArg(tok, min, max, &v)) return 0;
+        lista[(*num)++] = v;
     }
-    
-    if (nuevoAncho <= 0 || nuevoAlto <= 0) {
-        printf("❌ Error: Dimensiones inválidas (%dx%d)\n", nuevoAncho, nuevoAlto);
-        return;
+    return *num > 0;
+}
+
+static int compararEnteros(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+void mostrarUsoBench(const char* programa) {
+    printf("Uso: %s --bench [opciones...]\n", programa);
+    printf("  --sizes L             Megapíxeles de las imágenes sintéticas (0.1..100; por defecto 1,4,16)\n");
+    printf("  --channels L          Canales (1..4; por defecto 1,3)\n");
+    printf("  --threads L           Hilos, p. ej. 1,2,4 o 1-%d (por defecto potencias de 2 hasta los núcleos)\n",
+           MAX_HILOS);
+    printf("  --kernels L           Kernels de convolución (impares, 3..51; por defecto 3,15,51)\n");
+    printf("  --reps N              Repeticiones medidas por caso (1..1000; por defecto 5)\n");
+    printf("  --csv RUTA            Escribir resultados en CSV\n");
+    printf("  --json RUTA           Escribir resultados en JSON\n");
+}
+
+int analizarOpcionesBench(int argc, char* argv[], OpcionesBench* ob) {
+    memset(ob, 0, sizeof(*ob));
+    ob->tamanosMP[0] = 1.0;
+    ob->tamanosMP[1] = 4.0;
+    ob->tamanosMP[2] = 16.0;
+    ob->numTamanos = 3;
+    ob->canales[0] = 1;
+    ob->canales[1] = 3;
+    ob->numCanales = 2;
+    ob->kernels[0] = 3;
+    ob->kernels[1] = 15;
+    ob->kernels[2] = 51;
+    ob->numKernels = 3;
+    ob->repeticiones = 5;
+    
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nucleos < 1) nucleos = MAX_HILOS_DEFAULT;
+    if (nucleos > MAX_HILOS) nucleos = MAX_HILOS;
+    for (int h = 1; h < nucleos; h *= 2) ob->hilos[ob->numHilos++] = h;
+    ob->hilos[ob->numHilos++] = (int)nucleos;
+    
+    for (int i = 2; i < argc; i++) {
+        const char* opcion = argv[i];
+        const char* valor = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = valor != NULL;
+        
+        if (strcmp(opcion, "--sizes") == 0) {
+            ok = ok && leerListaReales(valor, 0.1f, 100.0f, ob->tamanosMP, &ob->numTamanos);
+        } else if (strcmp(opcion, "--channels") == 0) {
+            ok = ok && leerListaEnteros(valor, 1, 4, ob->canales, &ob->numCanales);
+        } else if (strcmp(opcion, "--threads") == 0) {
+            ok = ok && leerListaEnteros(valor, MIN_HILOS, MAX_HILOS, ob->hilos, &ob->numHilos);
+        } else if (strcmp(opcion, "--kernels") == 0) {
+            ok = ok && leerListaEnteros(valor, 3, 51, ob->kernels, &ob->numKernels);
+            for (int k = 0; ok && k < ob->numKernels; k++) ok = ob->kernels[k] % 2 == 1;
+        } else if (strcmp(opcion, "--reps") == 0) {
+            ok = ok && leerEnteroArg(valor, 1, 1000, &ob->repeticiones);
+        } else if (strcmp(opcion, "--csv") == 0) {
+            ob->rutaCSV = valor;
+        } else if (strcmp(opcion, "--json") == 0) {
+            ob->rutaJSON = valor;
+        } else {
+            fprintf(stderr, "❌ Opción de benchmark desconocida: %s\n", opcion);
+            mostrarUsoBench(argv[0]);
+            return 0;
+        }
+        
+        if (!ok) {
+            fprintf(stderr, "❌ Valor inválido para %s\n", opcion);
+            return 0;
+        }
+        i++;
     }
     
-    if (numHilos < MIN_HILOS) numHilos = MIN_HILOS;
-    if (numHilos > MAX_HILOS) numHilos = MAX_HILOS;
-    
-    int anchoSrc = info->ancho, altoSrc = info->alto;
-    
-    printf("🔧 Redimensionando imagen de %dx%d a %dx%d con %d hilos...\n",
-           anchoSrc, altoSrc, nuevoAncho, nuevoAlto, numHilos);
-    
-    unsigned char*** dst = crearMatrizPixeles(nuevoAlto, nuevoAncho, info->canales);
-    if (!dst) {
-        fprintf(stderr, "❌ Error: No se pudo crear matriz destino para resize\n");
-        return;
+    // La eficiencia se calcula respecto al primer número de hilos
+    qsort(ob->hilos, (size_t)ob->numHilos, sizeof(int), compararEnteros);
+    return 1;
+}
+
+// Ejecuta una vez el caso sobre una copia fresca de src (la copia no se
+// mide). Devuelve los segundos de la operación o -1 si falta memoria.
+static double medirCasoBench(const CasoBench* caso, const ImagenInfo* src, const char* rutaTemporal,
+                             int numHilos) {
+    ImagenInfo img = {0, 0, 0, 0, NULL};
+    double t0, dt;
+    
+    if (caso->op == BENCH_CARGAR) {
+        t0 = tiempoActual();
+        int ok = cargarImagen(rutaTemporal, &img, 1);
+        dt = tiempoActual() - t0;
+        liberarImagen(&img);
+        return ok ? dt : -1.0;
     }
-    
-    float scaleX = (float)anchoSrc / (float)nuevoAncho;
-    float scaleY = (float)altoSrc / (float)nuevoAlto;
-    
-    if (numHilos > nuevoAlto) numHilos = nuevoAlto;
-    
-    pthread_t* hilos = malloc(sizeof(pthread_t) * (size_t)numHilos);
-    ResizeArgs* args = malloc(sizeof(ResizeArgs) * (size_t)numHilos);
-    
-    if (!hilos || !args) {
-        fprintf(stderr, "❌ Error: Memoria insuficiente para hilos\n");
-        free(hilos);
-        free(args);
-        freeMatriz(dst, nuevoAlto, nuevoAncho);
-        return;
+    if (caso->op == BENCH_GUARDAR) {
+        t0 = tiempoActual();
+        int ok = guardarPNG(src, rutaTemporal, NULL, numHilos);
+        dt = tiempoActual() - t0;
+        return ok ? dt : -1.0;
     }
     
-    int filas = (nuevoAlto + numHilos - 1) / numHilos;
-    int hilosCreados = 0;
-    
-    for (int i = 0; i < numHilos; i++) {
-        args[i].src = info->pixeles;
-        args[i].dst = dst;
-        args[i].inicio = i * filas;
-        args[i].fin = ((i + 1) * filas < nuevoAlto) ? (i + 1) * filas : nuevoAlto;
-        args[i].anchoSrc = anchoSrc;
-        args[i].altoSrc = altoSrc;
-        args[i].anchoDst = nuevoAncho;
-        args[i].altoDst = nuevoAlto;
-        args[i].canales = info->canales;
-        args[i].scaleX = scaleX;
-        args[i].scaleY = scaleY;
-        args[i].hiloId = i;
-        
-        if (args[i].inicio < args[i].fin) {
-            if (pthread_create(&hilos[i], NULL, resizeWorker, &args[i]) != 0) {
-                fprintf(stderr, "⚠ Advertencia: No se pudo crear hilo %d\n", i);
-                args[i].inicio = args[i].fin;
-            } else {
-                hilosCreados++;
-            }
+    if (!crearImagen(&img, src->ancho, src->alto, src->canales)) return -1.0;
+    memcpy(img.pixeles, src->pixeles, src->stride * (size_t)src->alto);
+    
+    int ok;
+    t0 = tiempoActual();
+    switch (caso->op) {
+        case BENCH_BRILLO:
+            ok = ajustarBrilloConcurrente(&img, caso->parametro, numHilos);
+            break;
+        case BENCH_CONVOLUCION:
+            ok = aplicarConvolucionConcurrente(&img, caso->parametro, caso->parametro / 6.0f, numHilos);
+            break;
+        case BENCH_ROTAR:
+            ok = rotarImagenConcurrente(&img, (float)caso->parametro, numHilos);
+            break;
+        case BENCH_SOBEL:
+            ok = detectarBordesSobelConcurrente(&img, numHilos);
+            break;
+        default: {
+            int w = src->ancho * caso->parametro / 100, h = src->alto * caso->parametro / 100;
+            ok = redimensionarConcurrente(&img, w > 0 ? w : 1, h > 0 ? h : 1, numHilos, caso->filtro);
+            break;
         }
     }
+    dt = tiempoActual() - t0;
     
-    for (int i = 0; i < numHilos; i++) {
-        if (args[i].inicio < args[i].fin) {
-            pthread_join(hilos[i], NULL);
+    liberarImagen(&img);
+    return ok ? dt : -1.0;
+}
+
+static void escribirCSVBench(FILE* f, const ResultadoBench* r, int num) {
+    fprintf(f, "operacion,parametro,ancho,alto,canales,megapixeles,hilos,mediana_ms,p95_ms,mp_por_s,eficiencia\n");
+    for (int i = 0; i < num; i++) {
+        fprintf(f, "%s,%d,%d,%d,%d,%.3f,%d,%.3f,%.3f,%.2f,%.3f\n", r[i].operacion, r[i].parametro,
+                r[i].ancho, r[i].alto, r[i].canales, (double)r[i].ancho * r[i].alto / 1e6, r[i].hilos,
+                r[i].mediana * 1e3, r[i].p95 * 1e3, r[i].mpPorSegundo, r[i].eficiencia);
+    }
+}
+
+static void escribirJSONBench(FILE* f, const ResultadoBench* r, int num, const OpcionesBench* ob) {
+#if defined(__AVX2__)
+    const char* simd = "avx2";
+#elif defined(__SSE2__)
+    const char* simd = "sse2";
+#else
+    const char* simd = "escalar";
+#endif
+    fprintf(f, "{\n  \"simd\": \"%s\",\n  \"nucleos\": %ld,\n  \"repeticiones\": %d,\n  \"resultados\": [\n",
+            simd, sysconf(_SC_NPROCESSORS_ONLN), ob->repeticiones);
+    for (int i = 0; i < num; i++) {
+        fprintf(f, "    {\"operacion\": \"%s\", \"parametro\": %d, \"ancho\": %d, \"alto\": %d, "
+                   "\"canales\": %d, \"hilos\": %d, \"mediana_ms\": %.3f, \"p95_ms\": %.3f, "
+                   "\"mp_por_s\": %.2f, \"eficiencia\": %.3f}%s\n",
+                r[i].operacion, r[i].parametro, r[i].ancho, r[i].alto, r[i].canales, r[i].hilos,
+                r[i].mediana * 1e3, r[i].p95 * 1e3, r[i].mpPorSegundo, r[i].eficiencia,
+                i + 1 < num ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static int escribirInformeBench(const char* ruta, int json, const ResultadoBench* r, int num,
+                                const OpcionesBench* ob) {
+    FILE* f = fopen(ruta, "w");
+    if (!f) {
+        fprintf(stderr, "❌ No se pudo escribir %s: %s\n", ruta, strerror(errno));
+        return 0;
+    }
+    if (json) escribirJSONBench(f, r, num, ob);
+    else escribirCSVBench(f, r, num);
+    int ok = fclose(f) == 0;
+    if (ok) printf("📝 Resultados guardados en %s\n", ruta);
+    return ok;
+}
+
+// Mide cada operación sobre imágenes sintéticas de cada tamaño y número de
+// canales, para cada número de hilos: una ejecución de calentamiento y
+// 'repeticiones' medidas, cada una sobre una copia fresca de la imagen.
+// Cargar usa stb (un solo hilo) y solo se mide con el primer número de hilos.
+int ejecutarBench(const OpcionesBench* ob) {
+    CasoBench casos[8 + BENCH_MAX_LISTA];
+    int numCasos = 0;
+    casos[numCasos++] = (CasoBench){BENCH_BRILLO, "brillo", 20, FILTRO_AUTO};
+    for (int k = 0; k < ob->numKernels; k++) {
+        casos[numCasos++] = (CasoBench){BENCH_CONVOLUCION, "convolucion", ob->kernels[k], FILTRO_AUTO};
+    }
+    casos[numCasos++] = (CasoBench){BENCH_ROTAR, "rotar", 30, FILTRO_AUTO};
+    casos[numCasos++] = (CasoBench){BENCH_SOBEL, "sobel", 0, FILTRO_AUTO};
+    casos[numCasos++] = (CasoBench){BENCH_RESIZE, "resize-auto", 50, FILTRO_AUTO};
+    casos[numCasos++] = (CasoBench){BENCH_RESIZE, "resize-lanczos", 75, FILTRO_LANCZOS3};
+    casos[numCasos++] = (CasoBench){BENCH_CARGAR, "cargar", 0, FILTRO_AUTO};
+    casos[numCasos++] = (CasoBench){BENCH_GUARDAR, "guardar", NIVEL_PNG_DEFECTO, FILTRO_AUTO};
+    
+    char rutaTemporal[BUFFER_SIZE];
+    const char* dirTemporal = getenv("TMPDIR");
+    snprintf(rutaTemporal, sizeof(rutaTemporal), "%s/parcial2_bench_%ld.png",
+             dirTemporal ? dirTemporal : "/tmp", (long)getpid());
+    
+    int maxResultados = ob->numTamanos * ob->numCanales * numCasos * ob->numHilos;
+    ResultadoBench* resultados = (ResultadoBench*)malloc((size_t)maxResultados * sizeof(ResultadoBench));
+    double* tiempos = (double*)malloc((size_t)ob->repeticiones * sizeof(double));
+    if (!resultados || !tiempos) {
+        free(resultados);
+        free(tiempos);
+        fprintf(stderr, "❌ Error: Memoria insuficiente para el benchmark\n");
+        return EXIT_FAILURE;
+    }
+    int numResultados = 0, errores = 0;
+    
+    printf("Benchmark de filtros: %d repeticiones por caso (+1 de calentamiento)\n", ob->repeticiones);
+    printf("%-15s %5s %11s %3s %5s %12s %12s %10s %8s\n",
+           "Operación", "Param", "Tamaño", "Can", "Hilos", "Mediana ms", "p95 ms", "MP/s", "Efic.");
+    
+    for (int t = 0; t < ob->numTamanos; t++) {
+        double mp = ob->tamanosMP[t];
+        // Proporción 16:9
+        int ancho = (int)lround(sqrt(mp * 1e6 * 16.0 / 9.0));
+        int alto = (int)lround(mp * 1e6 / ancho);
+        if (alto < 1) alto = 1;
+        
+        for (int c = 0; c < ob->numCanales; c++) {
+            ImagenInfo src;
+            if (!generarImagenSintetica(&src, ancho, alto, ob->canales[c])) {
+                fprintf(stderr, "❌ Error: No se pudo generar la imagen %dx%d\n", ancho, alto);
+                errores++;
+                continue;
+            }
+            
+            int silencio = silenciarStdout();
+            int hayArchivo = guardarPNG(&src, rutaTemporal, NULL, ob->hilos[ob->numHilos - 1]);
+            restaurarStdout(silencio);
+            
+            for (int k = 0; k < numCasos; k++) {
+                const CasoBench* caso = &casos[k];
+                double base = 0.0;
+                int hilosBase = 0;
+                if (caso->op == BENCH_CARGAR && !hayArchivo) continue;
+                
+                for (int h = 0; h < ob->numHilos; h++) {
+                    if (caso->op == BENCH_CARGAR && h > 0) break;
+                    int hilos = ob->hilos[h];
+                    int fallo = 0;
+                    
+                    silencio = silenciarStdout();
+                    fallo = medirCasoBench(caso, &src, rutaTemporal, hilos) < 0.0;
+                    for (int r = 0; r < ob->repeticiones && !fallo; r++) {
+                        tiempos[r] = medirCasoBench(caso, &src, rutaTemporal, hilos);
+                        fallo = tiempos[r] < 0.0;
+                    }
+                    restaurarStdout(silencio);
+                    
+                    if (fallo) {
+                        fprintf(stderr, "❌ %s falló en %dx%d con %d hilos\n", caso->nombre, ancho, alto, hilos);
+                        errores++;
+                        break;
+                    }
+                    
+                    qsort(tiempos, (size_t)ob->repeticiones, sizeof(double), compararDoubles);
+                    ResultadoBench* res = &resultados[numResultados++];
+                    res->operacion = caso->nombre;
+                    res->parametro = caso->parametro;
+                    res->ancho = ancho;
+                    res->alto = alto;
+                    res->canales = ob->canales[c];
+                    res->hilos = hilos;
+                    res->mediana = (ob->repeticiones % 2) ? tiempos[ob->repeticiones / 2]
+                                 : 0.5 * (tiempos[ob->repeticiones / 2 - 1] + tiempos[ob->repeticiones / 2]);
+                    res->p95 = tiempos[(int)ceil(0.95 * ob->repeticiones) - 1];
+                    res->mpPorSegundo = (double)ancho * alto / 1e6 / res->mediana;
+                    if (hilosBase == 0) {
+                        base = res->mediana;
+                        hilosBase = hilos;
+                    }
+                    res->eficiencia = base * hilosBase / (res->mediana * hilos);
+                    
+                    printf("%-15s %5d %5dx%-5d %3d %5d %12.2f %12.2f %10.1f %7.0f%%\n",
+                           res->operacion, res->parametro, ancho, alto, res->canales, hilos,
+                           res->mediana * 1e3, res->p95 * 1e3, res->mpPorSegundo, res->eficiencia * 100.0);
+                    fflush(stdout);
+                }
+            }
+            
+            liberarImagen(&src);
         }
     }
+    remove(rutaTemporal);
     
-    int canales_orig = info->canales;
-    
-    liberarImagen(info);
-    info->ancho = nuevoAncho;
-    info->alto = nuevoAlto;
-    info->canales = canales_orig;
-    info->pixeles = dst;
+    if (ob->rutaCSV && !escribirInformeBench(ob->rutaCSV, 0, resultados, numResultados, ob)) errores++;
+    if (ob->rutaJSON && !escribirInformeBench(ob->rutaJSON, 1, resultados, numResultados, ob)) errores++;
     
-    free(hilos);
-    free(args);
-    printf("✓ Redimensionamiento completado (%d hilos utilizados)\n", hilosCreados);
+    free(resultados);
+    free(tiempos);
+    return errores == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 // ============================================================================
@@ -1072,10 +5420,10 @@ void mostrarMenu() {
     printf("║     Incrementar/decrementar luminosidad (-255 a +255)    ║\n");
     printf("║                                                          ║\n");
     printf("║  5. 🌫️  Aplicar desenfoque Gaussiano                      ║\n");
-    printf("║     Suavizar imagen con convolucion (kernel 3x3, 5x5)    ║\n");
+    printf("║     Convolucion separable en dos pasadas (kernel 3-51)   ║\n");
     printf("║                                                          ║\n");
-    printf("║  6. 🔄 Rotar imagen                                      ║\n");
-    printf("║     Rotacion con interpolacion bilineal (cualquier deg)  ║\n");
+    printf("║  6. 🔄 Rotar / voltear imagen                            ║\n");
+    printf("║     Bilineal (cualquier deg), exacta en 90/180/270       ║\n");
     printf("║                                                          ║\n");
     printf("║  7. 🔍 Detectar bordes (Sobel)                           ║\n");
     printf("║     Resaltar contornos y gradientes                      ║\n");
@@ -1083,7 +5431,13 @@ void mostrarMenu() {
     printf("║  8. 📐 Redimensionar                                     ║\n");
     printf("║     Cambiar tamaño con interpolacion de calidad          ║\n");
     printf("║                                                          ║\n");
-    printf("║  9. 👋 Salir                                             ║\n");
+    printf("║  9. 🎛️  Ajustes de tono                                   ║\n");
+    printf("║     Contraste, gamma, niveles, curvas... en una pasada   ║\n");
+    printf("║                                                          ║\n");
+    printf("║ 10. 📈 Métricas                                          ║\n");
+    printf("║     JSON, contadores hardware (perf), traza Perfetto     ║\n");
+    printf("║                                                          ║\n");
+    printf("║  0. 👋 Salir                                             ║\n");
     printf("╚══════════════════════════════════════════════════════════╝\n");
     printf("\n🎯 Opcion: ");
 }
@@ -1098,29 +5452,114 @@ void mostrarEstadoImagen(const ImagenInfo* info) {
         printf("║  📏 Dimensiones: %-5d x %-5d píxeles                   ║\n", 
                info->ancho, info->alto);
         printf("║  🎨 Canales: %d (%s)                                     ║\n", 
-               info->canales, info->canales == 1 ? "Escala de grises" : "RGB");
-        float mb = (info->alto * info->ancho * info->canales) / (1024.0f * 1024.0f);
+               info->canales, nombreCanales(info->canales));
+        float mb = (float)(((double)info->alto * (double)info->stride) / (1024.0 * 1024.0));
         printf("║  💽 Memoria: %.2f MB                                    ║\n", mb);
     } else {
         printf("║  ❌ No hay imagen cargada                                ║\n");
         printf("║  💡 Use la opcion 1 para cargar una imagen               ║\n");
     }
     
+    const MetricasOperacion* m = ultimaMetrica();
+    if (m) {
+        printf("╠══════════════════════════════════════════════════════════╣\n");
+        printf("║  ⏱  Última operación: %-34s ║\n", m->nombre);
+        printf("║     %9.2f ms | %2d/%-2d hilos | reserva %8.2f ms     ║\n",
+               m->tiempoPared * 1e3, m->hilosUsados, m->hilosPedidos, m->tiempoReserva * 1e3);
+        printf("║     Desbalance %5.2f | utilización %3.0f%%                  ║\n",
+               desbalanceMetricas(m), utilizacionMetricas(m) * 100.0);
+        // Ocupación por hilo en ms: los rezagados destacan frente al resto
+        char linea[128] = "";
+        int largo = 0, mostrados = 0;
+        for (int i = 0; i < MAX_HILOS && largo < 44; i++) {
+            if (m->bloques[i] == 0) continue;
+            largo += snprintf(linea + largo, sizeof(linea) - (size_t)largo, " %.1f", m->ocupado[i] * 1e3);
+            mostrados++;
+        }
+        if (mostrados < m->hilosUsados && largo < (int)sizeof(linea) - 4) strcat(linea, " …");
+        if (mostrados > 0) printf("║     Ocupado (ms):%-40s ║\n", linea);
+        if (m->perfilHardware) {
+            char contadores[128];
+            describirContadores(m, contadores, sizeof(contadores));
+            printf("║     🔬 %-49s ║\n", contadores);
+        }
+    }
+    
     printf("╚══════════════════════════════════════════════════════════╝\n");
 }
 
 int main(int argc, char* argv[]) {
-    ImagenInfo imagen = {0, 0, 0, NULL};
+    ImagenInfo imagen = {0, 0, 0, 0, NULL};
     char ruta[BUFFER_SIZE];
     
+    nombrarHiloTraza("principal");
+    
+    if (argc > 1 && strcmp(argv[1], "--bench-sobel") == 0) {
+        int hilos = (argc > 2) ? atoi(argv[2]) : MAX_HILOS_DEFAULT;
+        if (hilos < MIN_HILOS) hilos = MIN_HILOS;
+        if (hilos > MAX_HILOS) hilos = MAX_HILOS;
+        iniciarPoolHilos();
+        int res = benchSobel(hilos);
+        destruirPoolHilos();
+        return res;
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        OpcionesBench opciones;
+        if (!analizarOpcionesBench(argc, argv, &opciones)) return EXIT_FAILURE;
+        iniciarPoolHilos();
+        int res = ejecutarBench(&opciones);
+        destruirPoolHilos();
+        liberarCacheTablas();
+        return res;
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--bench-png") == 0) {
+        int hilos = (argc > 2) ? atoi(argv[2]) : MAX_HILOS_DEFAULT;
+        if (hilos < MIN_HILOS) hilos = MIN_HILOS;
+        if (hilos > MAX_HILOS) hilos = MAX_HILOS;
+        iniciarPoolHilos();
+        int res = benchPNG(hilos, (argc > 3) ? argv[3] : NULL);
+        destruirPoolHilos();
+        return res;
+    }
+    
+    // Cualquier opción "--" activa el modo sin menú (pipeline)
+    int modoPipeline = 0, ayuda = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) == 0) modoPipeline = 1;
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) ayuda = 1;
+    }
+    if (ayuda) {
+        mostrarUsoLineaComandos(argv[0]);
+        return EXIT_SUCCESS;
+    }
+    if (modoPipeline) {
+        Pipeline pipeline;
+        if (!analizarLineaComandos(argc, argv, &pipeline)) return EXIT_FAILURE;
+        activarPerfilHardware(pipeline.perfilHardware);
+        iniciarPoolHilos();
+        if (pipeline.rutaTraza) iniciarTraza();
+        int res = pipeline.lote ? ejecutarLote(&pipeline) : ejecutarPipeline(&pipeline);
+        if (pipeline.rutaTraza) {
+            detenerTraza();
+            if (!exportarTraza(pipeline.rutaTraza)) res = EXIT_FAILURE;
+        }
+        if (pipeline.rutaMetricas && !exportarMetricasJSON(pipeline.rutaMetricas)) res = EXIT_FAILURE;
+        destruirPoolHilos();
+        liberarCacheTablas();
+        return res;
+    }
+    
     mostrarBanner();
+    iniciarPoolHilos();
     
     // Cargar imagen desde argumentos si se proporciona
     if (argc > 1) {
         strncpy(ruta, argv[1], sizeof(ruta) - 1);
         ruta[sizeof(ruta) - 1] = '\0';
         printf("🚀 Cargando imagen desde argumentos: %s\n", ruta);
-        if (!cargarImagen(ruta, &imagen)) {
+        if (!cargarImagen(ruta, &imagen, 0)) {
             printf("⚠ No se pudo cargar la imagen. Puede cargar otra desde el menú.\n");
         }
     }
@@ -1133,7 +5572,7 @@ int main(int argc, char* argv[]) {
         
         if (scanf("%d", &opcion) != 1) {
             limpiarBuffer();
-            printf("\n❌ Entrada inválida. Por favor ingrese un número del 1 al 9.\n");
+            printf("\n❌ Entrada inválida. Por favor ingrese un número del 0 al 10.\n");
             continue;
         }
         limpiarBuffer();
@@ -1157,8 +5596,19 @@ int main(int argc, char* argv[]) {
                     break;
                 }
                 
+                printf("¿Conservar el canal alfa si la imagen lo tiene? (s/N): ");
+                char respuesta[16];
+                int conservarAlfa = 0;
+                if (fgets(respuesta, sizeof(respuesta), stdin) &&
+                    (respuesta[0] == 's' || respuesta[0] == 'S')) {
+                    conservarAlfa = 1;
+                }
+                
                 liberarImagen(&imagen);
-                cargarImagen(ruta, &imagen);
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "cargar", 1, &imagen);
+                cargarImagen(ruta, &imagen, conservarAlfa);
+                finalizarMetricas(&metricas, &imagen);
                 break;
             }
             
@@ -1207,7 +5657,16 @@ int main(int argc, char* argv[]) {
                     }
                 }
                 
-                guardarPNG(&imagen, out);
+                OpcionesPNG opciones;
+                opciones.nivel = validarEnteroRango("Nivel de compresión (0 = sin comprimir, 1 = rápido, 9 = máximo)",
+                                                    0, 9, NIVEL_PNG_DEFECTO);
+                printf("Filtro de filas: 0 = adaptativo, 1 = none, 2 = sub, 3 = up, 4 = average, 5 = paeth\n");
+                opciones.filtro = validarEnteroRango("Filtro", 0, 5, 0) - 1;
+                int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "guardar", threads, &imagen);
+                guardarPNG(&imagen, out, &opciones, threads);
+                finalizarMetricas(&metricas, &imagen);
                 break;
             }
             
@@ -1230,7 +5689,10 @@ int main(int argc, char* argv[]) {
                 if (delta == 0) {
                     printf("⚠ Ajuste de brillo = 0. No se realizarán cambios.\n");
                 } else {
+                    MetricasOperacion metricas;
+                    iniciarMetricas(&metricas, "brillo", threads, &imagen);
                     ajustarBrilloConcurrente(&imagen, delta, threads);
+                    finalizarMetricas(&metricas, &imagen);
                 }
                 break;
             }
@@ -1246,13 +5708,31 @@ int main(int argc, char* argv[]) {
                 printf("────────────────────────────────────────────────────────\n");
                 printf("El desenfoque Gaussiano suaviza la imagen aplicando una convolución.\n\n");
                 
+                printf("⚙️  MÉTODO:\n");
+                printf("  1. Kernel Gaussiano: resultado exacto, coste proporcional al kernel\n");
+                printf("  2. Rápido (tres cajas): aproximación con coste constante por píxel,\n");
+                printf("     ideal para sigmas grandes (10-50)\n\n");
+                
+                int metodo = validarEnteroRango("Método", 1, 2, 1);
+                
+                if (metodo == 2) {
+                    float sigma = validarFloatRango("Sigma (intensidad)", 0.5f, 50.0f, 10.0f);
+                    int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
+                    MetricasOperacion metricas;
+                    iniciarMetricas(&metricas, "desenfoque rápido", threads, &imagen);
+                    aplicarDesenfoqueRapidoConcurrente(&imagen, sigma, threads);
+                    finalizarMetricas(&metricas, &imagen);
+                    break;
+                }
+                printf("\n");
+                
                 printf("📏 TAMAÑO DEL KERNEL (debe ser IMPAR):\n");
                 printf("  • 3x3:   desenfoque muy ligero, procesamiento rápido\n");
                 printf("  • 5x5:   desenfoque ligero, buena velocidad\n");
                 printf("  • 7x7:   desenfoque moderado\n");
                 printf("  • 9x9:   desenfoque notable\n");
                 printf("  • 15x15: desenfoque fuerte\n");
-                printf("  • 25x25+: efectos artísticos extremos (lento)\n");
+                printf("  • 25x25+: efectos artísticos extremos\n");
                 printf("  ⚠ Solo números impares (3, 5, 7, 9, 11, etc.)\n\n");
                 
                 printf("🎚️  SIGMA (intensidad del desenfoque):\n");
@@ -1297,24 +5777,16 @@ int main(int argc, char* argv[]) {
                     printf("\n📊 Efecto esperado: Desenfoque extremo, efecto muy artístico\n");
                 }
                 
-                // Advertencia para kernels muy grandes
+                // El Gaussiano es separable: el coste crece con 2*tam, no con tam²
                 if (tam > 15) {
-                    printf("\n⚠ ADVERTENCIA: Kernel %dx%d es grande\n", tam, tam);
-                    printf("   • Tiempo de procesamiento: puede ser LENTO\n");
-                    printf("   • Uso de memoria: %d valores por píxel\n", tam * tam);
-                    printf("   • Recomendación: prueba con kernel más pequeño primero\n");
-                    printf("\n¿Continuar con kernel %dx%d? (s/N): ", tam, tam);
-                    char respuesta;
-                    if (scanf(" %c", &respuesta) == 1 && (respuesta == 's' || respuesta == 'S')) {
-                        limpiarBuffer();
-                        aplicarConvolucionConcurrente(&imagen, tam, sigma, threads);
-                    } else {
-                        limpiarBuffer();
-                        printf("⏭ Operación cancelada. Puedes intentar con un kernel más pequeño.\n");
-                    }
-                } else {
-                    aplicarConvolucionConcurrente(&imagen, tam, sigma, threads);
+                    printf("\n💡 Kernel %dx%d: se aplica en dos pasadas 1D (%d valores por píxel en vez de %d)\n",
+                           tam, tam, 2 * tam, tam * tam);
                 }
+                
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "desenfoque", threads, &imagen);
+                aplicarConvolucionConcurrente(&imagen, tam, sigma, threads);
+                finalizarMetricas(&metricas, &imagen);
                 break;
             }
             
@@ -1325,9 +5797,23 @@ int main(int argc, char* argv[]) {
                     break;
                 }
                 
-                printf("\n🔄 ROTAR IMAGEN\n");
+                printf("\n🔄 ROTAR / VOLTEAR IMAGEN\n");
                 printf("────────────────────────────────────────────────────────\n");
-                printf("Ingrese el ángulo de rotación:\n");
+                printf("  1. Rotar por ángulo (90°, 180° y 270° son exactos)\n");
+                printf("  2. Voltear horizontal (espejo izquierda-derecha)\n");
+                printf("  3. Voltear vertical (arriba-abajo)\n");
+                
+                int modo = validarEnteroRango("Operación", 1, 3, 1);
+                if (modo != 1) {
+                    int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
+                    MetricasOperacion metricas;
+                    iniciarMetricas(&metricas, "voltear", threads, &imagen);
+                    voltearImagenConcurrente(&imagen, modo == 2, modo == 3, threads);
+                    finalizarMetricas(&metricas, &imagen);
+                    break;
+                }
+                
+                printf("\nIngrese el ángulo de rotación:\n");
                 printf("  • Valores positivos: rotación antihoraria\n");
                 printf("  • Valores negativos: rotación horaria\n");
                 printf("  • Ejemplos: 90, -45, 180, 30.5\n");
@@ -1335,7 +5821,10 @@ int main(int argc, char* argv[]) {
                 float ang = validarFloatRango("Ángulo (grados)", -360.0f, 360.0f, 90.0f);
                 int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
                 
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "rotar", threads, &imagen);
                 rotarImagenConcurrente(&imagen, ang, threads);
+                finalizarMetricas(&metricas, &imagen);
                 break;
             }
             
@@ -1353,7 +5842,10 @@ int main(int argc, char* argv[]) {
                 
                 int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
                 
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "sobel", threads, &imagen);
                 detectarBordesSobelConcurrente(&imagen, threads);
+                finalizarMetricas(&metricas, &imagen);
                 break;
             }
             
@@ -1371,23 +5863,178 @@ int main(int argc, char* argv[]) {
                 
                 int w = validarEnteroRango("Nuevo ancho", 1, 10000, imagen.ancho / 2);
                 int h = validarEnteroRango("Nuevo alto", 1, 10000, imagen.alto / 2);
+                printf("Filtro:\n");
+                printf("  1. Automático (área + pirámide mip al reducir, bilineal al ampliar)\n");
+                printf("  2. Bilineal\n");
+                printf("  3. Área (promedio, sin aliasing en reducciones)\n");
+                printf("  4. Bicúbico Catmull-Rom\n");
+                printf("  5. Bicúbico Mitchell\n");
+                printf("  6. Lanczos-3 (máxima calidad)\n");
+                int filtro = validarEnteroRango("Filtro", 1, 6, 1);
                 int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
                 
-                redimensionarConcurrente(&imagen, w, h, threads);
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "redimensionar", threads, &imagen);
+                redimensionarConcurrente(&imagen, w, h, threads, (FiltroResize)(filtro - 1));
+                finalizarMetricas(&metricas, &imagen);
                 break;
             }
             
             case 9: {
+                // Cadena de operaciones puntuales
+                if (!imagen.pixeles) {
+                    printf("\n❌ No hay imagen cargada. Use la opción 1 primero.\n");
+                    break;
+                }
+                
+                printf("\n🎛️  AJUSTES DE TONO\n");
+                printf("────────────────────────────────────────────────────────\n");
+                printf("Agregue operaciones a la cadena; todas se combinan en una\n");
+                printf("sola tabla por canal y se aplican en una única pasada.\n");
+                
+                CadenaLUT cadena;
+                iniciarCadenaLUT(&cadena);
+                int aplicar = 1;
+                
+                while (1) {
+                    printf("\nCadena actual (%d): %s\n", cadena.numOperaciones,
+                           cadena.numOperaciones > 0 ? cadena.descripcion : "(vacía)");
+                    printf("  1. Brillo     2. Contraste   3. Gamma     4. Invertir\n");
+                    printf("  5. Umbral     6. Niveles     7. Curva por canal\n");
+                    printf("  8. Descartar  0. Aplicar cadena\n");
+                    
+                    int op = validarEnteroRango("Operación", 0, 8, 0);
+                    if (op == 0) break;
+                    if (op == 8) {
+                        aplicar = 0;
+                        break;
+                    }
+                    
+                    switch (op) {
+                        case 1:
+                            cadenaBrillo(&cadena, validarEnteroRango("Ajuste de brillo", -255, 255, 0));
+                            break;
+                        case 2:
+                            cadenaContraste(&cadena, validarFloatRango("Factor de contraste", 0.0f, 4.0f, 1.2f));
+                            break;
+                        case 3:
+                            cadenaGamma(&cadena, validarFloatRango("Gamma", 0.1f, 5.0f, 1.0f));
+                            break;
+                        case 4:
+                            cadenaInvertir(&cadena);
+                            break;
+                        case 5:
+                            cadenaUmbral(&cadena, validarEnteroRango("Umbral", 0, 255, 128));
+                            break;
+                        case 6: {
+                            int negroE = validarEnteroRango("Negro de entrada", 0, 254, 0);
+                            int blancoE = validarEnteroRango("Blanco de entrada", negroE + 1, 255, 255);
+                            float gamma = validarFloatRango("Gamma de tonos medios", 0.1f, 5.0f, 1.0f);
+                            int negroS = validarEnteroRango("Negro de salida", 0, 255, 0);
+                            int blancoS = validarEnteroRango("Blanco de salida", 0, 255, 255);
+                            cadenaNiveles(&cadena, negroE, blancoE, gamma, negroS, blancoS);
+                            break;
+                        }
+                        case 7: {
+                            printf("Canal: 0 = todos, 1 = R (o gris), 2 = G, 3 = B\n");
+                            int canal = validarEnteroRango("Canal", 0, 3, 0);
+                            int n = validarEnteroRango("Número de puntos de control", 2, 8, 3);
+                            int entrada[8], salida[8];
+                            int minEntrada = 0;
+                            for (int k = 0; k < n; k++) {
+                                printf("Punto %d:\n", k + 1);
+                                int maxEntrada = 255 - (n - 1 - k);
+                                int defecto = (k == n - 1) ? maxEntrada : minEntrada;
+                                entrada[k] = validarEnteroRango("  Entrada", minEntrada, maxEntrada, defecto);
+                                salida[k] = validarEnteroRango("  Salida", 0, 255, entrada[k]);
+                                minEntrada = entrada[k] + 1;
+                            }
+                            cadenaCurva(&cadena, canal == 0 ? CANAL_TODOS : canal - 1, entrada, salida, n);
+                            break;
+                        }
+                    }
+                }
+                
+                if (!aplicar) {
+                    printf("⏭ Cadena descartada. No se realizaron cambios.\n");
+                    break;
+                }
+                
+                if (cadena.numOperaciones == 0) {
+                    printf("⚠ Cadena vacía. No se realizarán cambios.\n");
+                    break;
+                }
+                
+                int threads = validarEnteroRango("Número de hilos", MIN_HILOS, MAX_HILOS, MAX_HILOS_DEFAULT);
+                MetricasOperacion metricas;
+                iniciarMetricas(&metricas, "ajustes de tono", threads, &imagen);
+                aplicarCadenaLUTConcurrente(&imagen, &cadena, threads);
+                finalizarMetricas(&metricas, &imagen);
+                break;
+            }
+            
+            case 10: {
+                // Métricas
+                printf("\n📈 MÉTRICAS\n");
+                printf("────────────────────────────────────────────────────────\n");
+                printf("  1. Exportar historial a JSON\n");
+                printf("  2. %s contadores hardware (ciclos, instrucciones, fallos LLC/dTLB)\n",
+                       perfilHardwareActivado() ? "Desactivar" : "Activar");
+                printf("  3. %s\n", trazando() ? "Detener la traza y guardarla (JSON para Perfetto)"
+                                                : "Iniciar traza de operaciones e hilos");
+                
+                int accion = validarEnteroRango("Operación", 1, 3, 1);
+                if (accion == 2) {
+                    activarPerfilHardware(!perfilHardwareActivado());
+                    printf("✓ Contadores hardware %s\n", perfilHardwareActivado()
+                           ? "activados: se medirán a partir de la próxima operación"
+                           : "desactivados");
+                    break;
+                }
+                if (accion == 3) {
+                    if (!trazando()) {
+                        iniciarTraza();
+                        printf("✓ Traza iniciada: se registran las operaciones hasta detenerla\n");
+                        break;
+                    }
+                    detenerTraza();
+                    char salidaTraza[BUFFER_SIZE];
+                    printf("Ingrese el nombre del archivo (Enter para traza.json): ");
+                    if (!fgets(salidaTraza, sizeof(salidaTraza), stdin)) salidaTraza[0] = '\0';
+                    salidaTraza[strcspn(salidaTraza, "\n")] = '\0';
+                    exportarTraza(strlen(salidaTraza) > 0 ? salidaTraza : "traza.json");
+                    break;
+                }
+                
+                if (!ultimaMetrica()) {
+                    printf("⚠ Todavía no se ha ejecutado ninguna operación.\n");
+                    break;
+                }
+                
+                char salida[BUFFER_SIZE];
+                printf("Ingrese el nombre del archivo JSON (Enter para metricas.json): ");
+                if (!fgets(salida, sizeof(salida), stdin)) {
+                    printf("❌ Error leyendo el nombre\n");
+                    break;
+                }
+                salida[strcspn(salida, "\n")] = '\0';
+                exportarMetricasJSON(strlen(salida) > 0 ? salida : "metricas.json");
+                break;
+            }
+            
+            case 0: {
                 // Salir
                 printf("\n👋 Cerrando aplicación...\n");
                 liberarImagen(&imagen);
+                destruirPoolHilos();
+                liberarCacheTablas();
                 printf("✓ Memoria liberada correctamente\n");
                 printf("¡Hasta pronto!\n\n");
                 return EXIT_SUCCESS;
             }
             
             default: {
-                printf("\n❌ Opción inválida. Por favor seleccione una opción del 1 al 9.\n");
+                printf("\n❌ Opción inválida. Por favor seleccione una opción del 0 al 10.\n");
                 break;
             }
         }